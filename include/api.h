@@ -64,6 +64,26 @@ void Allreduce(DType* sendrecvbuf, uint64_t count,
                const std::string& comm_name = kMainCommName);
 template <typename OP>
 void Allreduce(Buffer& sendrecvbuf);
+/*!
+ * @brief non-blocking version of Allreduce, the reduction runs on a
+ *  background thread of the communicator, in the order collectives are
+ *  issued, sendrecvbuf must not be touched until the returned completion
+ *  is waited
+ *
+ *     Example: auto wc = IAllreduce<op::Sum>(&a[0], N);
+ *              ... compute ...
+ *              wc->Wait(); WorkCompletion::Delete(wc);
+ * @return completion of the allreduce
+ */
+template <typename OP, typename DType>
+WorkCompletion* IAllreduce(DType* sendrecvbuf, uint64_t count,
+                           const std::string& comm_name = kMainCommName);
+/*! @brief non-blocking version of Broadcast @sa IAllreduce */
+WorkCompletion* IBroadcast(void* sendrecv_data, uint64_t size, int root,
+                           const std::string& comm_name = kMainCommName);
+/*! @brief non-blocking version of Allgather @sa IAllreduce */
+WorkCompletion* IAllgather(std::vector<Buffer>& sendrecvbufs,
+                           const std::string& comm_name = kMainCommName);
 /*!
  * @brief loads the latest check point
  * @param global_model pointer to the globally shared model/state
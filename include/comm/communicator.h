@@ -37,6 +37,20 @@ using ReduceFunction = std::function<void(Buffer src, Buffer dst)>;
 using RawReduceFunction =
     std::function<void(const void* src, void* dst, uint64_t len)>;
 
+/*! @brief algorithms which can be used to perform Allreduce */
+enum class AllreduceAlgo : uint32_t {
+    /*! pick an algorithm according to buffer size */
+    kAuto = 0,
+    kRing = 1,
+    kTree = 2,
+    /*! two complementary binary trees, each one reducing half the buffer */
+    kDoubleTree = 3,
+    /*! reduce-scatter by recursive halving, allgather by recursive doubling */
+    kHalvingDoubling = 4,
+    /*! reduce within hosts, ring among host leaders, broadcast within hosts */
+    kHierarchical = 5,
+};
+
 /*! @brief interface of core Allreduce comm */
 class ICommunicator {
 public:
@@ -69,6 +83,14 @@ public:
     virtual WorkCompletion* ISend(Buffer sendbuf, int dest) = 0;
 
     virtual WorkCompletion* IRecv(Buffer recvbuf, int src) = 0;
+    /**
+     * @brief: tagged point to point, a receive takes the oldest message from
+     * src with its tag, or with any tag for kAnyTag, tags other than
+     * kDefaultTag need framed links, see RDC_TCP_FRAMED
+     */
+    virtual WorkCompletion* ISend(Buffer sendbuf, int dest, int tag) = 0;
+
+    virtual WorkCompletion* IRecv(Buffer recvbuf, int src, int tag) = 0;
 
     WorkCompletion* ISend(void* sendaddr, uint64_t size_in_bytes, int dest) {
         Buffer sendbuf(sendaddr, size_in_bytes);
@@ -89,23 +111,20 @@ public:
      * @param count number of elements to be reduced
      * @param reducer reduce function
      */
-    void Allreduce(Buffer sendrecvbuf, ReduceFunction reducer) {
-    }
+    virtual void Allreduce(Buffer sendrecvbuf, ReduceFunction reducer) = 0;
     /*!
      * @brief broadcasts data from root to every other node
      * @param sendrecvbuf_ buffer for both sending and receiving data
      * @param size the size of the data to be broadcasted
      * @param root the root worker id to broadcast the data
      */
-    void Broadcast(Buffer sendrecvbuf, int root) {
-    }
+    virtual void Broadcast(Buffer sendrecvbuf, int root) = 0;
 
     void Broadcast(void* sendrecvaddr, uint64_t size, int root) {
         Buffer sendrecvbuf(sendrecvaddr, size);
         Broadcast(sendrecvbuf, root);
     }
-    void Allgather(std::vector<Buffer> sendrecvbufs) {
-    }
+    virtual void Allgather(std::vector<Buffer> sendrecvbufs) = 0;
 
     void Allgather(std::vector<void*> sendrecvbufs_,
                    std::vector<uint64_t> sizes) {
@@ -117,6 +136,30 @@ public:
         }
         Allgather(sendrecvbufs);
     }
+    /*!
+     * @brief non-blocking version of Allreduce, the collective is queued to
+     *  a background progress thread and runs after every collective issued
+     *  before it on this communicator, sendrecvbuf must stay valid until the
+     *  returned completion is waited
+     * @return completion of the whole collective, release it with
+     *  WorkCompletion::Delete
+     */
+    virtual WorkCompletion* IAllreduce(Buffer sendrecvbuf,
+                                       ReduceFunction reducer) = 0;
+    /*! @brief non-blocking version of Broadcast @sa IAllreduce */
+    virtual WorkCompletion* IBroadcast(Buffer sendrecvbuf, int root) = 0;
+
+    WorkCompletion* IBroadcast(void* sendrecvaddr, uint64_t size, int root) {
+        Buffer sendrecvbuf(sendrecvaddr, size);
+        return IBroadcast(sendrecvbuf, root);
+    }
+    /*! @brief non-blocking version of Allgather @sa IAllreduce */
+    virtual WorkCompletion* IAllgather(std::vector<Buffer> sendrecvbufs) = 0;
+    /*!
+     * @brief run a task on the progress thread after every collective
+     *  issued before it on this communicator has finished
+     */
+    virtual void Enqueue(const std::function<void()>& task) = 0;
     /*! @brief gets rank of current node */
     int GetRank() const;
     /*! @brief gets total number of nodes */
@@ -156,5 +199,13 @@ public:
  */
 void Allreduce_(Buffer sendrecvbuf, ReduceFunction red, mpi::DataType dtype,
                 mpi::OpType op, const std::string& comm_name);
+/*!
+ * @brief non-blocking version of Allreduce_, do not use this function
+ *  directly
+ * @return completion of the collective
+ */
+WorkCompletion* IAllreduce_(Buffer sendrecvbuf, ReduceFunction red,
+                            mpi::DataType dtype, mpi::OpType op,
+                            const std::string& comm_name);
 }  // namespace comm
 }  // namespace rdc
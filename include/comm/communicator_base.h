@@ -19,6 +19,7 @@
 #include "comm/communicator.h"
 #include "comm/deamon.h"
 #include "common/status.h"
+#include "common/threadpool.h"
 #include "core/logging.h"
 #include "core/work_request.h"
 #include "transport/adapter.h"
@@ -32,7 +33,11 @@
 #include "transport/rdma/rdma_adapter.h"
 #include "transport/rdma/rdma_channel.h"
 #endif
+#ifdef RDC_USE_SHMEM
+#include "comm/shm_collective.h"
+#endif
 #include "comm/tracker.h"
+#include "comm/tuner.h"
 #include "core/mpi.h"
 namespace rdc {
 namespace comm {
@@ -114,6 +119,10 @@ public:
     WorkCompletion* ISend(Buffer sendbuf_, int dest);
 
     WorkCompletion* IRecv(Buffer recvbuf_, int src);
+
+    WorkCompletion* ISend(Buffer sendbuf_, int dest, int tag);
+
+    WorkCompletion* IRecv(Buffer recvbuf_, int src, int tag);
     /*! @brief barrier all nodes*/
     void Barrier();
     /*! @brief exclude communications with tracker by other communicator*/
@@ -130,10 +139,11 @@ public:
      * @param count number of elements to be reduced
      * @param reducer reduce function
      */
-    void Allreduce(Buffer sendrecvbuf_, ReduceFunction reducer) {
+    void Allreduce(Buffer sendrecvbuf_, ReduceFunction reducer) override {
         if (GetWorldSize() == 1 || GetWorldSize() == -1) {
             return;
         }
+        WaitCollectives();
         TryAllreduce(sendrecvbuf_, reducer);
     }
     /*!
@@ -142,21 +152,125 @@ public:
      * @param size the size of the data to be broadcasted
      * @param root the root worker id to broadcast the data
      */
-    void Broadcast(Buffer sendrecvbuf_, int root) {
+    void Broadcast(Buffer sendrecvbuf_, int root) override {
         if (GetWorldSize() == 1 || GetWorldSize() == -1)
             return;
+        WaitCollectives();
         TryBroadcast(sendrecvbuf_, root);
     }
 
-    void Allgather(std::vector<Buffer> sendrecvbufs_) {
+    void Allgather(std::vector<Buffer> sendrecvbufs_) override {
         if (GetWorldSize() == 1 || GetWorldSize() == -1)
             return;
-        TryAllgatherRing(sendrecvbufs_);
+        WaitCollectives();
+        TryAllgatherRing(sendrecvbufs_, GlobalRing());
+    }
+
+    WorkCompletion* IAllreduce(Buffer sendrecvbuf_,
+                               ReduceFunction reducer) override;
+
+    WorkCompletion* IBroadcast(Buffer sendrecvbuf_, int root) override;
+
+    WorkCompletion* IAllgather(std::vector<Buffer> sendrecvbufs_) override;
+    /*!
+     * @brief in-place allreduce of floats which are sent as bfloat16, half
+     *  the bytes cross every link and the result is rounded to bfloat16
+     * @param sendrecvbuf_ floats for both sending and recving data
+     * @param op reduction, bitwise ones have no meaning on bfloat16
+     */
+    void AllreduceBFloat16(Buffer sendrecvbuf_, const mpi::OpType& op) {
+        if (GetWorldSize() == 1 || GetWorldSize() == -1) {
+            return;
+        }
+        WaitCollectives();
+        TryAllreduceBFloat16(sendrecvbuf_, op);
+    }
+    /*! @brief non-blocking version of AllreduceBFloat16 */
+    WorkCompletion* IAllreduceBFloat16(Buffer sendrecvbuf_,
+                                       const mpi::OpType& op);
+
+    void Enqueue(const std::function<void()>& task) override;
+    /*!
+     * @brief block until every non-blocking collective issued on this
+     *  communicator has finished
+     */
+    void WaitCollectives() {
+        // the pool is created by the first enqueue and lives as long as this
+        std::unique_lock<std::mutex> progress_lock(progress_lock_);
+        auto* progress_pool = progress_pool_.get();
+        progress_lock.unlock();
+        if (progress_pool != nullptr) {
+            progress_pool->WaitAll();
+        }
     }
     std::unique_ptr<ICommunicator> CreateGroup(const std::vector<int>& ranks,
                                                const std::string& group_name);
+    /*!
+     * @brief measure every allreduce algorithm on message sizes growing by
+     *  4x from 1KB up to max_size_in_bytes, and record the fastest one of
+     *  each size in tuner, timings are max-reduced over all nodes so that
+     *  every node records the same table, must be called by all nodes
+     *
+     * @param tuner table to fill
+     * @param max_size_in_bytes largest message size to measure
+     * @param num_iters number of timed rounds per algorithm and size
+     */
+    void TuneAllreduce(CollectiveTuner* tuner, const uint64_t& max_size_in_bytes,
+                       const int& num_iters);
+    /*!
+     * @brief replace the table of every node with the one of node 0, tables
+     *  loaded from local files may differ, and nodes picking different
+     *  algorithms for one allreduce never finish it, must be called by all
+     *  nodes
+     *
+     * @param tuner table to share, or to overwrite
+     */
+    void ShareTuning(CollectiveTuner* tuner);
 
 protected:
+    /*!
+     * @brief a ring over a subset of nodes, rank and size are positions
+     * within the ring rather than global ranks, data is sent to prev and
+     * received from next
+     */
+    struct RingView {
+        IChannel* prev;
+        IChannel* next;
+        int rank;
+        int size;
+    };
+    /*! @brief the ring over all nodes set up by ReConnectLinks */
+    RingView GlobalRing() const {
+        return RingView{ring_prev_, ring_next_, GetRank(), GetWorldSize()};
+    }
+    /*!
+     * @brief get the lowest rank on every host, sorted, which is gathered
+     * from all nodes on first use and cached until links are rebuilt
+     */
+    const std::vector<int>& GetHostLeaders();
+#ifdef RDC_USE_SHMEM
+    /*!
+     * @brief get the shared memory arena for collectives, which is set up on
+     *  first use when all nodes live on one host, nullptr otherwise
+     */
+    ShmCollective* GetShmCollective();
+#endif
+    /*!
+     * @brief get a temporary buffer of size_in_bytes to receive data into,
+     *  the memory is reused by the next collective so at most one such
+     *  buffer can be alive at a time
+     */
+    Buffer GetReduceBuffer(const uint64_t& size_in_bytes,
+                           const uint64_t& item_size);
+    /*!
+     * @brief queue a collective to the progress thread
+     * @param ptr buffer of the collective, recorded in the work request
+     * @param size_in_bytes size of the buffer
+     * @param collective runs the collective in blocking fashion
+     * @return completion which is finished when collective returns
+     */
+    WorkCompletion* EnqueueCollective(void* ptr, const size_t& size_in_bytes,
+                                      const std::function<void()>& collective);
     /*!
      * @brief perform in-place allreduce, on sendrecvbuf, this function can
      * fail, and will return the cause of failure
@@ -167,7 +281,17 @@ protected:
      * kGetExcept, see void for details
      */
     void TryAllreduce(Buffer sendrecvbuf_, ReduceFunction reducer);
+    /*!
+     * @brief round sendrecvbuf_ into the wire scratch space, allreduce it
+     *  there and widen the result back
+     */
+    void TryAllreduceBFloat16(Buffer sendrecvbuf_, const mpi::OpType& op);
 
+    /*!
+     * @brief reduce sendrecvbuf to root along the tree, children are reduced
+     *  in the order their data arrives
+     * @param reducebuf_ holds one copy of sendrecvbuf_ per child
+     */
     void TryReduceTree(Buffer sendrecvbuf_, Buffer reducebuf_,
                        ReduceFunction reducer, int root);
     /*!
@@ -196,6 +320,45 @@ protected:
      * kGetExcept, see void for details \sa void
      */
     void TryAllreduceTree(Buffer sendrecvbuf_, ReduceFunction reducer);
+    /*!
+     * @brief perform in-place allreduce, on sendrecvbuf,
+     * using two complementary binary trees, the first half of the buffer is
+     * reduced and broadcasted along the first tree and the second half along
+     * the second one, since every node is a leaf in at least one of them,
+     * this gives logarithmic latency while using the full link bandwidth
+     *
+     * @param sendrecvbuf_ buffer for both sending and recving data
+     * @param reducer reduce function
+     * @sa GetDoubleTree
+     */
+    void TryAllreduceDoubleTree(Buffer sendrecvbuf_, ReduceFunction reducer);
+    /*!
+     * @brief perform in-place allreduce, on sendrecvbuf,
+     * using Rabenseifner's algorithm: a reduce-scatter by recursive halving
+     * followed by an allgather by recursive doubling, which takes 2 * log(p)
+     * steps instead of 2 * (p - 1) for the ring. When the world size is not a
+     * power of two, the first 2 * r nodes are folded pairwise beforehand and
+     * unfolded afterwards, where r is the world size minus the largest power
+     * of two below it
+     *
+     * @param sendrecvbuf_ buffer for both sending and recving data
+     * @param reducer reduce function
+     */
+    void TryAllreduceHalvingDoubling(Buffer sendrecvbuf_,
+                                     ReduceFunction reducer);
+    /*!
+     * @brief perform in-place allreduce, on sendrecvbuf,
+     * in two levels: nodes on the same host reduce to the lowest rank of the
+     * host over local links, which use shared memory when available, those
+     * host leaders run a ring allreduce among themselves, and finally every
+     * leader broadcasts the result to the nodes on its host. Only one copy
+     * of the data per host crosses the network
+     *
+     * @param sendrecvbuf_ buffer for both sending and recving data
+     * @param reducer reduce function
+     * @sa GetHostLeaders
+     */
+    void TryAllreduceHierarchical(Buffer sendrecvbuf_, ReduceFunction reducer);
     /*!
      * @brief internal Allgather function, each node have a segment of data in
      * the ring of sendrecvbuf, the data provided by current node k is
@@ -213,7 +376,8 @@ protected:
      * Status::kSuccess, kSockError, kGetExcept, see void for details
      * @sa void
      */
-    void TryAllgatherRing(std::vector<Buffer> sendrecvbufs_);
+    void TryAllgatherRing(std::vector<Buffer> sendrecvbufs_,
+                          const RingView& ring);
     /*!
      * @brief perform in-place allreduce, reduce on the sendrecvbuf,
      *
@@ -230,7 +394,22 @@ protected:
      * @sa void, TryAllreduce
      */
     void TryReduceScatterRing(Buffer sendrecvbuf_, Buffer reducebuf_,
-                              ReduceFunction reducer);
+                              ReduceFunction reducer, const RingView& ring);
+    /*!
+     * @brief pipelined version of TryReduceScatterRing, every segment is
+     *  split into sub-chunks of rdc_ring_chunk_size bytes, up to
+     *  rdc_ring_pipeline_depth sub-chunks are received ahead while earlier
+     *  ones are being reduced, and a reduced sub-chunk is forwarded to the
+     *  previous node as soon as it is ready
+     *
+     * @param sendrecvbuf_ buffer for both sending and recving data
+     * @param reducebuf_ buffer for reducing data
+     * @param reducer reduce function
+     * @sa TryReduceScatterRing
+     */
+    void TryReduceScatterRingPipelined(Buffer sendrecvbuf_, Buffer reducebuf_,
+                                       ReduceFunction reducer,
+                                       const RingView& ring);
     /*!
      * @brief perform in-place allreduce, on sendrecvbuf
      *  use a ring based algorithm, reduce-scatter + allgather
@@ -243,6 +422,8 @@ protected:
      * @sa void
      */
     void TryAllreduceRing(Buffer sendrecvbuf_, ReduceFunction reducer);
+    void TryAllreduceRing(Buffer sendrecvbuf_, ReduceFunction reducer,
+                          const RingView& ring);
 
     bool is_main_comm() const {
         return this->is_main_comm_;
@@ -267,6 +448,13 @@ protected:
     // pointer to links in the ring
     IChannel *ring_prev_, *ring_next_;
     int prev_rank_, next_rank_;
+    // lowest rank of every host, empty until first gathered
+    std::vector<int> host_leaders_;
+#ifdef RDC_USE_SHMEM
+    // arena shared by all nodes of a single host communicator
+    std::unique_ptr<ShmCollective> shm_collective_;
+    bool shm_collective_probed_;
+#endif
     //----- meta information-----
     // unique identifier of the possible job this process is doing
     // reduction method
@@ -277,6 +465,15 @@ protected:
     uint32_t children_counter_;
     std::mutex comm_lock_;
     std::unordered_map<std::string, std::unique_ptr<Communicator>> sub_comms_;
+    // single worker running non-blocking collectives in issue order
+    std::unique_ptr<ThreadPool> progress_pool_;
+    std::mutex progress_lock_;
+    // scratch space for received data, kept across collectives
+    void* reduce_scratch_;
+    uint64_t reduce_scratch_size_;
+    // bfloat16 copy of the floats being reduced, kept across collectives
+    void* wire_scratch_;
+    uint64_t wire_scratch_size_;
     bool is_main_comm_;
 };
 }  // namespace comm
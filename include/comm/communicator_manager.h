@@ -3,6 +3,9 @@
 #include "comm/communicator.h"
 #include "comm/deamon.h"
 #include "comm/tracker.h"
+#include "comm/fusion_buffer.h"
+#include "comm/parallel_reducer.h"
+#include "comm/tuner.h"
 #include "utils/lock_utils.h"
 
 namespace rdc {
@@ -83,6 +86,33 @@ public:
     size_t reduce_ring_mincount() const {
         return reduce_ring_mincount_;
     }
+    size_t reduce_rhd_maxcount() const {
+        return reduce_rhd_maxcount_;
+    }
+    AllreduceAlgo allreduce_algo() const {
+        return allreduce_algo_;
+    }
+    size_t ring_chunk_size() const {
+        return ring_chunk_size_;
+    }
+    size_t ring_pipeline_depth() const {
+        return ring_pipeline_depth_;
+    }
+    const CollectiveTuner& tuner() const {
+        return tuner_;
+    }
+    size_t fusion_threshold() const {
+        return fusion_threshold_;
+    }
+    FusionBuffer* fusion_buffer() const {
+        return fusion_buffer_.get();
+    }
+    bool allreduce_bf16_wire() const {
+        return allreduce_bf16_wire_;
+    }
+    ParallelReducer* parallel_reducer() const {
+        return parallel_reducer_.get();
+    }
     int heartbeat_interval() const {
         return heartbeat_interval_;
     }
@@ -110,6 +140,37 @@ private:
     utils::SpinLock comm_lock_;
     // mininum count of cells to use ring based method
     size_t reduce_ring_mincount_;
+    // maximum size in bytes to prefer recursive halving doubling over ring
+    size_t reduce_rhd_maxcount_;
+    // algorithm forced by rdc_allreduce_algo, kAuto selects by size
+    AllreduceAlgo allreduce_algo_;
+    // size in bytes of sub-chunks used by pipelined ring, 0 disables it
+    size_t ring_chunk_size_;
+    // maximum number of sub-chunks received ahead of the reduction
+    size_t ring_pipeline_depth_;
+    // fastest allreduce algorithm per size, used when the algorithm is kAuto
+    CollectiveTuner tuner_;
+    // file to load the tuning table from, and to save a measured one to
+    std::string tuning_file_;
+    // whether to measure a tuning table when none is loaded
+    bool autotune_;
+    // largest message size in bytes measured by the autotuner
+    size_t autotune_maxsize_;
+    // number of timed rounds per algorithm and size
+    int autotune_iters_;
+    // non-blocking allreduces up to this size in bytes are batched, 0
+    // disables batching
+    size_t fusion_threshold_;
+    // size in bytes of every staging buffer used for batching
+    size_t fusion_buffer_size_;
+    std::unique_ptr<FusionBuffer> fusion_buffer_;
+    // number of helper threads reducing large segments, 0 disables it
+    size_t reduce_threads_;
+    // segments from this size in bytes on are reduced by several threads
+    size_t reduce_parallel_minsize_;
+    std::unique_ptr<ParallelReducer> parallel_reducer_;
+    // whether float allreduces are sent as bfloat16 and widened on return
+    bool allreduce_bf16_wire_;
     utils::SpinLock tracker_lock_;
     std::shared_ptr<Deamon> deamon_;
     std::thread demaon_thrd_;
@@ -0,0 +1,74 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file fusion_buffer.h
+ * @brief batching of small non-blocking allreduces, requests on the same
+ *   communicator with the same data type and operator are packed into one
+ *   staging buffer and reduced by a single allreduce
+ *
+ *   a batch is flushed when it is full, when one of its requests is waited,
+ *   or explicitly, since every node issues and waits requests in the same
+ *   order, all nodes pack the same requests into the same batches
+ *
+ * \author Ankun Zheng
+ */
+#pragma once
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "comm/communicator.h"
+#include "core/mpi.h"
+#include "core/work_request.h"
+
+namespace rdc {
+namespace comm {
+class FusionBuffer {
+public:
+    /*!
+     * @param capacity size in bytes of every staging buffer, which is also
+     *  the largest batch
+     */
+    explicit FusionBuffer(const size_t& capacity);
+
+    ~FusionBuffer();
+    /*!
+     * @brief queue an allreduce to the batch of its communicator, data type
+     *  and operator, sendrecvbuf must be no larger than capacity and must
+     *  stay valid until the returned completion is waited
+     * @return completion which is finished once results are copied back
+     */
+    WorkCompletion* Add(const std::string& comm_name, Buffer sendrecvbuf,
+                        ReduceFunction reducer, const mpi::DataType& dtype,
+                        const mpi::OpType& op);
+    /*! @brief flush every pending batch, in a fixed order */
+    void FlushAll();
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    // communicator name, data type and operator of a batch
+    using BatchKey = std::tuple<std::string, int, int>;
+    struct Batch {
+        ReduceFunction reducer;
+        uint64_t item_size = 0;
+        uint64_t size_in_bytes = 0;
+        // user buffer and work request id of every queued allreduce
+        std::vector<std::pair<Buffer, uint64_t>> entries;
+    };
+    /*! @brief pack a batch into a staging buffer and issue its allreduce,
+     * must hold lock_ */
+    void FlushLocked(const BatchKey& key);
+    /*! @brief flush the batch if it is not empty */
+    void Flush(const BatchKey& key);
+
+    size_t capacity_;
+    std::map<BatchKey, Batch> batches_;
+    // staging buffers not used by any in-flight batch
+    std::vector<void*> free_staging_bufs_;
+    std::mutex lock_;
+};
+}  // namespace comm
+}  // namespace rdc
@@ -0,0 +1,52 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file parallel_reducer.h
+ * @brief splits the reduction of a large segment across a small set of
+ *   worker threads, so that reducing multi-megabyte chunks does not
+ *   stall the communication thread driving the ring
+ *
+ * \author Ankun Zheng
+ */
+#pragma once
+#include <memory>
+#include "comm/communicator.h"
+#include "common/threadpool.h"
+
+namespace rdc {
+namespace comm {
+class ParallelReducer {
+public:
+    /*!
+     * @param num_workers number of helper threads, the calling thread
+     *  reduces one more part itself
+     * @param min_size segments smaller than this size in bytes are reduced
+     *  by the calling thread only
+     */
+    ParallelReducer(const size_t& num_workers, const size_t& min_size);
+
+    ~ParallelReducer();
+    /*!
+     * @brief wrap a reducer so that large typed segments are reduced in
+     *  parallel, the reducer must be elementwise
+     */
+    ReduceFunction Wrap(const ReduceFunction& reducer);
+    /*! @brief reduce src into dst, splitting it by items when large enough */
+    void Reduce(Buffer src, Buffer dst, const ReduceFunction& reducer);
+
+    size_t num_workers() const {
+        return num_workers_;
+    }
+
+private:
+    /*! @brief pin the index-th worker to the index-th core after first_core_ */
+    void PinWorker(const size_t& index) const;
+
+    size_t num_workers_;
+    size_t min_size_;
+    // core of the first worker, RDC_REDUCE_CORE, workers are not pinned if
+    // negative
+    int first_core_;
+    std::unique_ptr<ThreadPool> pool_;
+};
+}  // namespace comm
+}  // namespace rdc
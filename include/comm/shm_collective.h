@@ -0,0 +1,67 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file shm_collective.h
+ * @brief collectives among ranks living on one host through a shared memory
+ *   arena, no message is exchanged between ranks
+ *
+ *   every rank owns a cache line of progress counters and two data slots in
+ *   the arena, the slots are used in turns by consecutive rounds. In a round
+ *   of allreduce every rank copies its chunk into its slot, then reduces a
+ *   disjoint slice of all slots in place into its own slot, and finally
+ *   copies every slice back from the slot of the rank which reduced it
+ *
+ * \author Ankun Zheng
+ */
+#pragma once
+#include <memory>
+#include <string>
+#include "comm/communicator.h"
+#include "transport/ipc/shm.h"
+
+namespace rdc {
+namespace comm {
+struct ShmCollectiveHeader;
+struct ShmCollectiveFlags;
+
+class ShmCollective {
+public:
+    /*!
+     * @param name name of the arena, the same on all ranks
+     * @param rank rank of this process among the ranks of the host
+     * @param world_size number of ranks on the host
+     * @param slot_size bytes each rank contributes per round
+     */
+    ShmCollective(const std::string& name, const int& rank,
+                  const int& world_size, const uint64_t& slot_size);
+
+    ~ShmCollective();
+    /*!
+     * @brief create or open the arena, the lowest rank creates it and the
+     *  last one to map it removes its name
+     * @return whether the arena is usable
+     */
+    bool Attach();
+    /*! @brief in-place allreduce of sendrecvbuf over all ranks of the arena */
+    void Allreduce(Buffer sendrecvbuf, ReduceFunction reducer);
+    /*! @brief broadcast sendrecvbuf from root to all ranks of the arena */
+    void Broadcast(Buffer sendrecvbuf, const int& root);
+
+private:
+    /*! @brief start a round, returns the slot of this rank to use */
+    uint8_t* BeginRound();
+
+    uint8_t* slot(const int& rank) const;
+
+    std::string name_;
+    int rank_;
+    int world_size_;
+    uint64_t slot_size_;
+    // rounds done by this rank, all ranks run the same sequence of rounds
+    uint64_t round_;
+    std::unique_ptr<Shm> shm_;
+    ShmCollectiveHeader* header_;
+    ShmCollectiveFlags* flags_;
+    uint8_t* slots_;
+};
+}  // namespace comm
+}  // namespace rdc
@@ -154,7 +154,6 @@ private:
     std::string host_uri_;
     // port of worker process
     int worker_port_, nport_trial_;
-    int shmem_worker_port_;
     int world_size_;
     int rank_;
     int num_conn_, num_accept_;
@@ -0,0 +1,75 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file tuner.h
+ * @brief table of the fastest collective algorithm per message size, either
+ *   measured when a communicator is created or loaded from a tuning file
+ *
+ *   the tuning file is plain text, one bucket per line as
+ *   "{max size in bytes} {algorithm}", sorted by size, lines starting with
+ *   '#' are ignored, e.g.
+ *
+ *       # rdc allreduce tuning table
+ *       65536 tree
+ *       4194304 rhd
+ *       18446744073709551615 ring
+ *
+ * \author Ankun Zheng
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "comm/communicator.h"
+
+namespace rdc {
+namespace comm {
+/*!
+ * @brief get the algorithm with the given short name
+ * @param name one of auto, ring, tree, dtree, rhd, hier
+ * @param algo the parsed algorithm
+ * @return whether the name is known
+ */
+bool AllreduceAlgoFromName(const std::string& name, AllreduceAlgo* algo);
+/*! @brief get the short name of an algorithm */
+std::string AllreduceAlgoName(const AllreduceAlgo& algo);
+
+class CollectiveTuner {
+public:
+    CollectiveTuner() = default;
+    ~CollectiveTuner() = default;
+    /*!
+     * @brief get the algorithm of the smallest bucket which holds the size
+     * @return kAuto if the table is empty
+     */
+    AllreduceAlgo Select(const uint64_t& size_in_bytes) const;
+    /*!
+     * @brief record the algorithm for sizes up to max_size_in_bytes, buckets
+     * must be added in increasing size
+     */
+    void Add(const uint64_t& max_size_in_bytes, const AllreduceAlgo& algo);
+    /*!
+     * @brief load table from a tuning file, the table is left empty if the
+     * file can not be read or parsed
+     * @return whether the table is loaded
+     */
+    bool Load(const std::string& path);
+    /*! @brief save table to a tuning file */
+    bool Save(const std::string& path) const;
+    /*! @brief drop all buckets */
+    void Clear() {
+        buckets_.clear();
+    }
+    bool empty() const {
+        return buckets_.empty();
+    }
+    const std::vector<std::pair<uint64_t, AllreduceAlgo>>& buckets() const {
+        return buckets_;
+    }
+
+private:
+    // upper bound in bytes and algorithm of every bucket, sorted by bound
+    std::vector<std::pair<uint64_t, AllreduceAlgo>> buckets_;
+};
+}  // namespace comm
+}  // namespace rdc
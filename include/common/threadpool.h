@@ -11,9 +11,18 @@ class ThreadPool {
 public:
     using Task = std::function<void(void)>;
     using TaskQueue = std::queue<Task>;
+    /*! @brief run once by every worker thread, with the worker index */
+    using WorkerInit = std::function<void(const size_t&)>;
     // Constructor
     ThreadPool();
     ThreadPool(const size_t& num_workers);
+    /**
+     * @brief: create workers which run worker_init before taking any task,
+     * e.g. to pin themselves to a core
+     */
+    ThreadPool(const size_t& num_workers, const WorkerInit& worker_init);
+
+    static ThreadPool* Get();
 
     // Deconstructor
     ~ThreadPool();
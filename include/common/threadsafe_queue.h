@@ -1,8 +1,10 @@
 #pragma once
+#include <algorithm>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <vector>
 
 /**
  * @brief thread-safe queue allowing push and waited pop
@@ -20,16 +22,39 @@ public:
      */
     void Push(T new_value) {
         mu_.lock();
-        queue_.push(std::move(new_value));
+        queue_.push_back(std::move(new_value));
         mu_.unlock();
         cond_.notify_all();
     }
 
     void Pop() {
         mu_.lock();
-        queue_.pop();
+        queue_.pop_front();
         mu_.unlock();
     }
+    /**
+     * @brief copy the first element into value if there is one, never blocks
+     * @return whether the queue is not empty
+     */
+    bool TryPeek(T& value) {
+        std::lock_guard<std::mutex> lg(mu_);
+        if (queue_.empty()) {
+            return false;
+        }
+        value = queue_.front();
+        return true;
+    }
+    /**
+     * @brief copy up to max_values elements from the front into values,
+     * never blocks
+     * @return the number of elements copied
+     */
+    size_t TryPeekFront(std::vector<T>* values, const size_t& max_values) {
+        std::lock_guard<std::mutex> lg(mu_);
+        const size_t num_values = std::min(max_values, queue_.size());
+        values->assign(queue_.begin(), queue_.begin() + num_values);
+        return num_values;
+    }
     template <typename Duration>
     bool WaitAndPeek(T& value, const Duration& timeout_) {
         std::unique_lock<std::mutex> lk(mu_);
@@ -49,7 +74,7 @@ public:
         std::unique_lock<std::mutex> lk(mu_);
         cond_.wait(lk, [this] { return !queue_.empty(); });
         *value = std::move(queue_.front());
-        queue_.pop();
+        queue_.pop_front();
     }
 
     bool empty() {
@@ -63,6 +88,6 @@ public:
 
 private:
     mutable std::mutex mu_;
-    std::queue<T> queue_;
+    std::deque<T> queue_;
     std::condition_variable cond_;
 };
@@ -0,0 +1,162 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file coroutine.h
+ * @brief optional c++20 coroutine layer over work completions, empty when
+ *   compiled against an older standard
+ *
+ *   a coroutine awaiting a work completion is resumed by the done callback
+ *   of its request, that is on the thread completing the request, usually a
+ *   poller thread of the channel, so it must never block on a work request
+ *   while it runs there, awaiting is fine
+ *
+ *   Task is the return type of such coroutines, it starts eagerly and its
+ *   completion is done when the coroutine returns, so tasks can be awaited
+ *   by other tasks or waited on like any other work completion
+ *
+ *     rdc::Task Step(rdc::comm::ICommunicator* comm, Buffer buf) {
+ *         co_await rdc::Await(comm->IRecv(buf, 0));
+ *         co_await rdc::Await(comm->IAllreduce(buf, reducer));
+ *     }
+ *
+ * \author Ankun Zheng
+ */
+#pragma once
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+#include <atomic>
+#include <coroutine>
+#include <utility>
+#include "core/work_request.h"
+
+namespace rdc {
+/**
+ * @brief: awaits a work completion and deletes it afterwards, co_await
+ * evaluates to the final status of the work request
+ */
+class WorkAwaiter {
+public:
+    explicit WorkAwaiter(WorkCompletion* work_comp)
+        : work_comp_(work_comp), resumable_(false) {
+    }
+
+    ~WorkAwaiter() {
+        if (work_comp_ != nullptr) {
+            WorkCompletion::Delete(work_comp_);
+        }
+    }
+
+    WorkAwaiter(WorkAwaiter&& other) noexcept
+        : work_comp_(std::exchange(other.work_comp_, nullptr)),
+          resumable_(false) {
+    }
+
+    WorkAwaiter(const WorkAwaiter&) = delete;
+
+    bool await_ready() {
+        return work_comp_->Test();
+    }
+    /**
+     * @brief: the done callback and this call race, whoever comes second
+     * resumes, so a request done meanwhile does not suspend at all
+     */
+    bool await_suspend(std::coroutine_handle<> handle) {
+        handle_ = handle;
+        work_comp_->OnDone([this](const WorkStatus&) {
+            if (resumable_.exchange(true, std::memory_order_acq_rel)) {
+                handle_.resume();
+            }
+        });
+        return !resumable_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    WorkStatus await_resume() {
+        return work_comp_->status();
+    }
+
+private:
+    WorkCompletion* work_comp_;
+    std::coroutine_handle<> handle_;
+    std::atomic<bool> resumable_;
+};
+/*! @brief co_await the work of work_comp, which is taken over */
+inline WorkAwaiter Await(WorkCompletion* work_comp) {
+    return WorkAwaiter(work_comp);
+}
+
+/**
+ * @brief: a coroutine running a schedule of work requests, backed by a work
+ * request of its own which is finished when the coroutine returns, or gets
+ * an error status when it throws
+ */
+class Task {
+public:
+    struct promise_type {
+        promise_type()
+            : req_id(WorkRequestManager::Get()->NewWorkRequest(
+                  WorkType::kCollective, static_cast<void*>(nullptr), 0)) {
+        }
+
+        Task get_return_object() {
+            return Task(WorkCompletion::New(req_id));
+        }
+
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() {
+            Finish(WorkStatus::kFinished);
+        }
+
+        void unhandled_exception() {
+            LOG_F(ERROR, "coroutine of work request %lu threw", req_id);
+            Finish(WorkStatus::kError);
+        }
+
+        void Finish(const WorkStatus& status) {
+            auto& work_req = WorkRequestManager::Get()->GetWorkRequest(req_id);
+            work_req.set_status(status);
+            work_req.Notify();
+        }
+
+        uint64_t req_id;
+    };
+
+    Task(Task&& other) noexcept
+        : work_comp_(std::exchange(other.work_comp_, nullptr)) {
+    }
+
+    Task(const Task&) = delete;
+
+    ~Task() {
+        if (work_comp_ != nullptr) {
+            WorkCompletion::Delete(work_comp_);
+        }
+    }
+    /**
+     * @brief: hand over the completion of this task, to wait on it together
+     * with other work completions
+     */
+    WorkCompletion* Release() {
+        return std::exchange(work_comp_, nullptr);
+    }
+
+    void Wait() {
+        work_comp_->Wait();
+    }
+
+    WorkAwaiter operator co_await() && {
+        return WorkAwaiter(Release());
+    }
+
+private:
+    explicit Task(WorkCompletion* work_comp) : work_comp_(work_comp) {
+    }
+
+    WorkCompletion* work_comp_;
+};
+}  // namespace rdc
+#endif
@@ -0,0 +1,115 @@
+/*!
+ * Copyright by Contributors
+ * \file half.h
+ * \brief 16 bit floating point types, ieee half precision and bfloat16,
+ *  stored as raw bits and computed on in single precision
+ *
+ * \author Ankun Zheng
+ */
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+namespace rdc {
+namespace half_utils {
+inline uint32_t FloatBits(const float& f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    return x;
+}
+inline float BitsFloat(const uint32_t& x) {
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+/*! \brief float to half, round to nearest even, overflow goes to inf */
+inline uint16_t FloatToHalfBits(const float& f) {
+    const uint32_t kF16Max = (127 + 16) << 23;
+    const uint32_t kF32Inf = 255 << 23;
+    // adding it shifts half subnormals into the low mantissa bits
+    const uint32_t kDenormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+    uint32_t x = FloatBits(f);
+    const uint32_t sign = x & 0x80000000U;
+    x ^= sign;
+    uint16_t bits = 0;
+    if (x >= kF16Max) {
+        bits = x > kF32Inf ? 0x7E00 : 0x7C00;
+    } else if (x < (113U << 23)) {
+        bits = static_cast<uint16_t>(
+            FloatBits(BitsFloat(x) + BitsFloat(kDenormMagic)) - kDenormMagic);
+    } else {
+        const uint32_t mant_odd = (x >> 13) & 1;
+        x += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFF + mant_odd;
+        bits = static_cast<uint16_t>(x >> 13);
+    }
+    return bits | static_cast<uint16_t>(sign >> 16);
+}
+inline float HalfBitsToFloat(const uint16_t& bits) {
+    const uint32_t kShiftedExp = 0x7C00 << 13;
+    uint32_t x = (bits & 0x7FFFU) << 13;
+    const uint32_t exp = x & kShiftedExp;
+    x += (127 - 15) << 23;
+    if (exp == kShiftedExp) {
+        // inf or nan
+        x += (128 - 16) << 23;
+    } else if (exp == 0) {
+        // zero or subnormal, renormalize
+        x += 1 << 23;
+        x = FloatBits(BitsFloat(x) - BitsFloat(113U << 23));
+    }
+    return BitsFloat(x | ((bits & 0x8000U) << 16));
+}
+/*! \brief float to bfloat16, round to nearest even, nan stays quiet nan */
+inline uint16_t FloatToBFloat16Bits(const float& f) {
+    const uint32_t x = FloatBits(f);
+    if ((x & 0x7FFFFFFFU) > 0x7F800000U) {
+        return static_cast<uint16_t>((x >> 16) | 0x40);
+    }
+    return static_cast<uint16_t>((x + 0x7FFF + ((x >> 16) & 1)) >> 16);
+}
+inline float BFloat16BitsToFloat(const uint16_t& bits) {
+    return BitsFloat(static_cast<uint32_t>(bits) << 16);
+}
+}  // namespace half_utils
+
+/*! \brief ieee 754 half precision */
+struct Half {
+    uint16_t bits;
+    Half() = default;
+    explicit Half(const float& f) : bits(half_utils::FloatToHalfBits(f)) {
+    }
+    explicit operator float() const {
+        return half_utils::HalfBitsToFloat(bits);
+    }
+};
+/*! \brief upper half of an ieee 754 single precision */
+struct BFloat16 {
+    uint16_t bits;
+    BFloat16() = default;
+    explicit BFloat16(const float& f)
+        : bits(half_utils::FloatToBFloat16Bits(f)) {
+    }
+    explicit operator float() const {
+        return half_utils::BFloat16BitsToFloat(bits);
+    }
+};
+
+// operators used by the scalar reducers, computed in single precision
+#define RDC_HALF_OPERATORS(T)                                    \
+    inline bool operator<(const T& lhs, const T& rhs) {          \
+        return static_cast<float>(lhs) < static_cast<float>(rhs); \
+    }                                                            \
+    inline bool operator>(const T& lhs, const T& rhs) {          \
+        return static_cast<float>(lhs) > static_cast<float>(rhs); \
+    }                                                            \
+    inline bool operator==(const T& lhs, const T& rhs) {         \
+        return static_cast<float>(lhs) == static_cast<float>(rhs); \
+    }                                                            \
+    inline T& operator+=(T& lhs, const T& rhs) { /* NOLINT(*) */ \
+        lhs = T(static_cast<float>(lhs) + static_cast<float>(rhs)); \
+        return lhs;                                              \
+    }
+RDC_HALF_OPERATORS(Half)
+RDC_HALF_OPERATORS(BFloat16)
+#undef RDC_HALF_OPERATORS
+}  // namespace rdc
@@ -6,6 +6,9 @@
  * \author Ankun Zheng
  */
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include "core/half.h"
 namespace rdc {
 namespace mpi {
 /*!\brief enum of all operators */
@@ -26,7 +29,9 @@ enum DataType {
     kFloat = 6,
     kDouble = 7,
     kLongLong = 8,
-    kULongLong = 9
+    kULongLong = 9,
+    kHalf = 10,
+    kBFloat16 = 11
 };
 // MPI data type to be compatible with existing MPI interface
 class Datatype {
@@ -79,6 +84,14 @@ template<>
 inline DataType GetType<unsigned long long>(void) { // NOLINT(*)
     return kULongLong;
 }
+template<>
+inline DataType GetType<Half>(void) {
+    return kHalf;
+}
+template<>
+inline DataType GetType<BFloat16>(void) {
+    return kBFloat16;
+}
 }  // namespace mpi
 
 namespace op {
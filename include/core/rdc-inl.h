@@ -8,10 +8,12 @@
 #pragma once
 // use comm for implementation
 #include <string>
+#include <type_traits>
 #include <vector>
 #include "comm/communicator_manager.h"
 #include "comm/tracker.h"
 #include "core/mpi.h"
+#include "core/reduce_kernels.h"
 #include "io/io.h"
 #include "io/memory_io.h"
 #include "rdc.h"
@@ -121,19 +123,54 @@ inline void Allgather(std::vector<std::vector<DType>> &sendrecv_data,
     Allgather(sendrecvbufs, comm_name);
 }
 
+// reduce function backed by the vectorized kernel of OP on DType
+template <typename OP, typename DType>
+inline comm::ReduceFunction MakeReducer() {
+    static_assert(OP::kType != mpi::kBitwiseOR || std::is_integral<DType>::value,
+                  "BitOR is only defined on integer types");
+    auto kernel = op::GetReduceKernel(OP::kType, mpi::GetType<DType>());
+    CHECK_F(kernel != nullptr, "no reduce kernel for op %d on data type %d",
+            static_cast<int>(OP::kType),
+            static_cast<int>(mpi::GetType<DType>()));
+    return [kernel](Buffer src, Buffer dst) {
+        kernel(src.addr(), dst.addr(), src.Count());
+    };
+}
+
 // perform inplace Allreduce
 template <typename OP, typename DType>
 inline void Allreduce(DType *sendrecvbuf_, uint64_t count,
                       const std::string &comm_name) {
     Buffer sendrecvbuf(sendrecvbuf_, count * sizeof(DType));
     sendrecvbuf.set_item_size(sizeof(DType));
-    auto reducer = [](Buffer src, Buffer dst) {
-        op::Reducer<OP, DType>(src.addr(), dst.addr(), src.Count());
-    };
+    auto reducer = MakeReducer<OP, DType>();
     comm::Allreduce_(sendrecvbuf, reducer, mpi::GetType<DType>(), OP::kType,
                      comm_name);
 }
 
+// perform non-blocking inplace Allreduce
+template <typename OP, typename DType>
+inline WorkCompletion *IAllreduce(DType *sendrecvbuf_, uint64_t count,
+                                  const std::string &comm_name) {
+    Buffer sendrecvbuf(sendrecvbuf_, count * sizeof(DType));
+    sendrecvbuf.set_item_size(sizeof(DType));
+    auto reducer = MakeReducer<OP, DType>();
+    return comm::IAllreduce_(sendrecvbuf, reducer, mpi::GetType<DType>(),
+                             OP::kType, comm_name);
+}
+inline WorkCompletion *IBroadcast(void *sendrecvaddr, uint64_t size, int root,
+                                  const std::string &comm_name) {
+    return comm::CommunicatorManager::Get()
+        ->GetCommunicator(comm_name)
+        ->IBroadcast(sendrecvaddr, size, root);
+}
+inline WorkCompletion *IAllgather(std::vector<Buffer> &sendrecvbufs,
+                                  const std::string &comm_name) {
+    return comm::CommunicatorManager::Get()
+        ->GetCommunicator(comm_name)
+        ->IAllgather(sendrecvbufs);
+}
+
 // ---------------------------------
 // Code to handle customized Reduce
 // ---------------------------------
@@ -0,0 +1,37 @@
+/*!
+ * Copyright by Contributors
+ * \file reduce_kernels.h
+ * \brief vectorized kernels of the built-in reduction operators, the widest
+ *  instruction set supported by the running cpu is picked once on first use
+ *
+ * \author Ankun Zheng
+ */
+#pragma once
+#include <cstdint>
+#include "core/mpi.h"
+
+namespace rdc {
+namespace op {
+/*!
+ * \brief reduce len elements of src into dst, in the same form as
+ *  op::Reducer
+ */
+using ReduceKernel = void (*)(const void* src, void* dst, uint64_t len);
+/*!
+ * \brief get the fastest kernel of an operator on a data type
+ * \return nullptr if the operator is not defined on the data type, e.g.
+ *  BitOR on floating point types
+ */
+ReduceKernel GetReduceKernel(const mpi::OpType& op,
+                             const mpi::DataType& dtype);
+/*!
+ * \brief round len floats of src to bfloat16, to nearest even, used to
+ *  halve the bytes sent on the wire
+ */
+void FloatToBFloat16(const float* src, BFloat16* dst, uint64_t len);
+/*! \brief widen len bfloat16 values of src to float, exactly */
+void BFloat16ToFloat(const BFloat16* src, float* dst, uint64_t len);
+/*! \brief name of the instruction set used by the kernels, for logging */
+const char* ReduceKernelIsa();
+}  // namespace op
+}  // namespace rdc
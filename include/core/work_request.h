@@ -3,10 +3,10 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
-#include <unordered_map>
 #include "common/any.h"
 #include "common/object_pool.h"
 #include "common/semaphore.h"
@@ -18,6 +18,8 @@ namespace rdc {
 enum class WorkType : uint32_t {
     kSend,
     kRecv,
+    /*! a whole collective running on the progress thread of a communicator */
+    kCollective,
 };
 
 enum class WorkStatus : uint32_t {
@@ -28,33 +30,39 @@ enum class WorkStatus : uint32_t {
     kClosed = 1 << 5,
     kError = 1 << 6,
 };
+/*! @brief whether a work request with this status will not change anymore */
+inline bool IsDone(const WorkStatus& status) {
+    return status == WorkStatus::kFinished || status == WorkStatus::kCanceled ||
+           status == WorkStatus::kClosed || status == WorkStatus::kError;
+}
 
+class WorkRequestManager;
+/**
+ * @brief: a slot of the work request slab, reused by many work requests one
+ * after another, the id of the current one tells its slot and generation
+ */
 class WorkRequest {
 public:
     WorkRequest();
 
-    WorkRequest(const uint64_t& req_id, const WorkType& work_type, void* ptr,
-                const size_t& size);
-
-    WorkRequest(const uint64_t& req_id, const WorkType& work_type,
-                const void* ptr, const size_t& size);
-
     ~WorkRequest() = default;
 
-    WorkRequest(const WorkRequest& other);
+    WorkRequest(const WorkRequest& other) = delete;
 
-    WorkRequest& operator=(const WorkRequest& other);
+    WorkRequest& operator=(const WorkRequest& other) = delete;
 
     /**
      * @brief: add number of bytes readed/wrote by last run to total completed
      * bytes
      *
      * @param nbytes number of bytes readed/wrote by channel
+     * @param finish whether all bytes transferred also means finished, not so
+     * for zero copy sends whose pages are still held by the kernel
      * note: this function will be called by channel so it will be consumed by
      * single consumer
-     * @return
+     * @return whether all bytes are transferred
      */
-    bool AddBytes(const size_t nbytes);
+    bool AddBytes(const size_t nbytes, const bool& finish = true);
 
     /**
      * @brief: return the underlying pointer at certain position with expected
@@ -73,6 +81,8 @@ public:
     /**
      * @brief: wait this work request to finish, when wait return, this work
      * request is either finished, canceled, or the related channel is closed
+     * note: a notification sent after the status became final may reach the
+     * next work request of this slot, so only a final status ends the wait
      */
     void Wait();
 
@@ -80,6 +90,25 @@ public:
      * @brief: notify wait to return
      */
     void Notify();
+    /**
+     * @brief: set a hook which is invoked by Wait when this work request is
+     * still pending, used by deferred requests which only start when someone
+     * is waiting for them
+     */
+    void set_wait_callback(const std::function<void()>& wait_callback) {
+        wait_callback_ = wait_callback;
+    }
+    /**
+     * @brief: invoke the wait callback if this work request is still pending
+     */
+    void StartIfDeferred();
+    /**
+     * @brief: run callback with the final status once this work request is
+     * done, on the thread which sets that status, usually a poller thread of
+     * the channel, or right away on the calling thread if it is done already
+     * note: callbacks must not block, each of them runs exactly once
+     */
+    void AddDoneCallback(const std::function<void(const WorkStatus&)>& callback);
     /***********************properties********************************/
     size_t size_in_bytes() const;
 
@@ -119,7 +148,18 @@ public:
     }
 
 private:
-    /*! @brief request id which start from 0 */
+    friend class WorkRequestManager;
+    /*! @brief start a new work request in this slot */
+    void Reset(const uint64_t& req_id, const WorkType& work_type, void* ptr,
+               const size_t& size);
+    /*! @brief give the slot back once both references are dropped */
+    void Unref();
+    /*! @brief drop the reference held until the status is final */
+    void MarkDone();
+    /*! @brief run the done callbacks, only the first call does anything */
+    void RunDoneCallbacks(const WorkStatus& status);
+
+    /*! @brief generation in the upper half, slot index in the lower half */
     uint64_t req_id_;
     /*! @brief work request type, either send or recv*/
     WorkType work_type_;
@@ -135,28 +175,36 @@ private:
     any extra_data_;
     /*! @brief needed when wait*/
     LightweightSemaphore sema_;
-    std::function<void()> done_callback_;
+    /*! @brief run once when the status becomes final */
+    std::vector<std::function<void(const WorkStatus&)>> done_callbacks_;
+    /*! @brief guards done_callbacks_ against the completing thread */
+    utils::SpinLock callback_lock_;
+    bool callbacks_run_;
+    /*! @brief invoked by Wait while this work request is pending */
+    std::function<void()> wait_callback_;
+    /*! @brief held by the work completion and by the unfinished request */
+    std::atomic<uint32_t> refs_;
+    std::atomic<bool> done_;
+    /*! @brief next slot in the free list */
+    std::atomic<uint32_t> next_free_;
 };
 
+/**
+ * @brief: owns all work requests in a slab of slots which grows by chunks up
+ * to a fixed capacity and never shrinks, a slot is recycled once the work
+ * completion of its request is deleted and the request is done, slots are
+ * taken from and given back to a lock free free list
+ */
 class WorkRequestManager {
 public:
-    WorkRequestManager();
-
-    ~WorkRequestManager() = default;
+    explicit WorkRequestManager(const uint32_t& capacity);
 
-    explicit WorkRequestManager(const WorkRequestManager&) = default;
+    ~WorkRequestManager();
 
-    WorkRequestManager(WorkRequestManager&&) = default;
+    WorkRequestManager(const WorkRequestManager&) = delete;
 
     static WorkRequestManager* Get();
 
-    /**
-     * @brief: add the work requst to manager
-     * note: a copy will be invoked here, be careful of it
-     * @param req the work requst need to be added to manager
-     */
-    void AddWorkRequest(const WorkRequest& req);
-
     /**
      * @brief: create a new work requst and the assign a work requst id to id
      *
@@ -187,29 +235,23 @@ public:
     template <typename T>
     uint64_t NewWorkRequest(const WorkType& work_type, void* ptr,
                             const size_t& size, const T& extra_data) {
-        id_lock_->lock();
-        cur_req_id_++;
-        WorkRequest work_req(cur_req_id_, work_type, ptr, size);
-        work_req.set_extra_data(extra_data);
-        id_lock_->unlock();
-        AddWorkRequest(work_req);
-        return work_req.id();
+        auto req_id = NewWorkRequest(work_type, ptr, size);
+        GetWorkRequest(req_id).set_extra_data(extra_data);
+        return req_id;
     }
 
     template <typename T>
     uint64_t NewWorkRequest(const WorkType& work_type, const void* ptr,
                             const size_t& size, const T& extra_data) {
-        id_lock_->lock();
-        cur_req_id_++;
-        WorkRequest work_req(cur_req_id_, work_type, ptr, size);
-        work_req.set_extra_data(extra_data);
-        id_lock_->unlock();
-        AddWorkRequest(work_req);
-        return work_req.id();
+        auto req_id = NewWorkRequest(work_type, ptr, size);
+        GetWorkRequest(req_id).set_extra_data(extra_data);
+        return req_id;
     }
 
     WorkRequest& GetWorkRequest(const uint64_t& req_id);
-
+    /**
+     * @brief: whether req_id is the current work request of its slot
+     */
     bool Contain(const uint64_t& req_id);
 
     /*note: the following method will be triggered through the underlying
@@ -221,21 +263,53 @@ public:
     size_t processed_bytes_upto_now(const uint64_t& req_id);
 
     WorkStatus status(const uint64_t& req_id);
-
+    /**
+     * @brief: set status of a work request, ignored when the request is
+     * gone already
+     */
     void set_status(const uint64_t& req_id, const WorkStatus& status);
+    /**
+     * @brief: drop the reference of the work completion of req_id
+     */
+    void Release(const uint64_t& req_id);
+    /**
+     * @brief: block until pred holds, pred is evaluated again whenever any
+     * work request gets a final status
+     */
+    void WaitUntil(const std::function<bool()>& pred);
 
 private:
-    uint64_t cur_req_id_;
+    friend class WorkRequest;
+    static const uint32_t kChunkSize = 1024;
+    static const uint32_t kNilIndex = UINT32_MAX;
 
-    std::unordered_map<uint64_t, WorkRequest> all_work_reqs;
-
-    /*! @brief lock needed when add a new work requst to work requests hashmap*/
-    std::unique_ptr<utils::SpinLock> store_lock_;
-    /*! @brief lock needed when generate a globally consistent auto increment
-     * since it only use few instructions, a spinlock is enough for this
-     * operation*/
-    std::unique_ptr<utils::SpinLock> id_lock_;
-    // used when we do not want workrequest shutdown by themselves, deprecated
+    WorkRequest& Slot(const uint32_t& index) {
+        return chunks_[index / kChunkSize].load(
+            std::memory_order_acquire)[index % kChunkSize];
+    }
+    /*! @brief take a free slot, or a fresh one when none is free */
+    uint32_t AllocSlot();
+    /*! @brief push a slot whose work request is gone onto the free list */
+    void FreeSlot(const uint32_t& index);
+    /*! @brief wake WaitUntil, called when a work request gets a final status */
+    void NotifyDone();
+
+    uint32_t capacity_;
+    /*! @brief chunks of slots, allocated on first use */
+    std::unique_ptr<std::atomic<WorkRequest*>[]> chunks_;
+    /*! @brief serializes allocation of chunks, off the hot path */
+    std::mutex chunk_lock_;
+    /*! @brief number of slots ever handed out */
+    std::atomic<uint32_t> num_slots_;
+    /*! @brief index of the first free slot, tagged by a pop counter in the
+     * upper half against aba */
+    std::atomic<uint64_t> free_head_;
+    /*! @brief shared by all waits on sets of work requests, the epoch moves
+     * whenever some work request is done */
+    std::mutex done_lock_;
+    std::condition_variable done_cond_;
+    uint64_t done_epoch_;
+    std::atomic<int> num_set_waiters_;
 };
 
 /**
@@ -246,9 +320,9 @@ class WorkCompletion : public ObjectPoolAllocatable<WorkCompletion> {
 public:
     WorkCompletion(const uint64_t& id);
 
-    WorkCompletion(const WorkCompletion& other) = default;
-
-    WorkCompletion(WorkCompletion&& other) = default;
+    ~WorkCompletion();
+    /*! @brief every work completion holds one reference to its request */
+    WorkCompletion(const WorkCompletion& other) = delete;
 
     /**
      * @brief: get the id of the corresponding work request
@@ -261,12 +335,48 @@ public:
      * @brief: invoke waiting of the underlying work request
      */
     void Wait();
+    /**
+     * @brief: whether the underlying work request is done, never blocks
+     */
+    bool Test();
     /**
      * @brief: get the status of the corresponding work request
      *
      * @return status of corresponding work request
      */
     WorkStatus status();
+    /**
+     * @brief: block until at least one of work_comps is done
+     *
+     * @return index of a done one, the lowest if several are
+     */
+    static size_t WaitAny(const std::vector<WorkCompletion*>& work_comps);
+    /**
+     * @brief: block until at least one of work_comps is done
+     *
+     * @return indices of all done ones, in increasing order
+     */
+    static std::vector<size_t> WaitSome(
+        const std::vector<WorkCompletion*>& work_comps);
+    /**
+     * @brief: block until all of work_comps are done, in whatever order
+     */
+    static void WaitAll(const std::vector<WorkCompletion*>& work_comps);
+    /**
+     * @brief: run callback with the final status of the underlying work
+     * request, see WorkRequest::AddDoneCallback, a deferred request is started
+     */
+    void OnDone(const std::function<void(const WorkStatus&)>& callback);
+    /**
+     * @brief: start the work returned by next once this one is finished,
+     * without any thread blocking in between, next runs where the done
+     * callbacks run and may return nullptr when there is nothing to start
+     *
+     * @return a new work completion which is done when the work started by
+     * next is done, or with the status of this one if it did not finish, this
+     * one is still owned and deleted by the caller
+     */
+    WorkCompletion* Then(const std::function<WorkCompletion*()>& next);
 
 private:
     uint64_t id_;
@@ -281,9 +391,11 @@ public:
 
     ~ChainWorkCompletion();
 
-    void Push(WorkCompletion* work_comp);
-
-    bool done();
+    void Add(WorkCompletion* work_comp);
+    /**
+     * @brief: whether all work completions are done, never blocks
+     */
+    bool Test();
 
     void Wait();
 
@@ -11,6 +11,7 @@ enum Backend {
     kTcp = 0,
     kRdma = 2,
     kIpc = 3,
+    kIoUring = 4,
 };
 /* !\brief parse a address before connecting, a valid address is represented
  * as a tuple (backend, host, port) and will be represented as a string like
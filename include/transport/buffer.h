@@ -3,9 +3,6 @@
 #include <infiniband/verbs.h>
 #include "transport/rdma/rdma_memory_mgr.h"
 #endif
-#ifdef RDC_USE_SHMEM
-#include "transport/ipc/shm.h"
-#endif
 #include "common/env.h"
 #include "common/object_pool.h"
 #include "common/pool.h"
@@ -95,20 +92,6 @@ public:
 #endif
     }
 
-#if RDC_USE_SHMEM
-    ~Buffer() {
-        if (use_shm_) {
-            shm_->Close();
-        }
-    }
-    void set_memfile_name(const std::string memfile_name) {
-        memfile_name_ = memfile_name;
-    }
-    void set_shm(std::shared_ptr<Shmem> shm) {
-        shm_ = shm;
-        use_shm_ = true;
-    }
-#endif
     Buffer Slice(const uint64_t& start, const uint64_t& end) const {
         Buffer subbuffer((void*)((int8_t*)addr_ + start), end - start, start,
                          end);
@@ -234,8 +217,8 @@ private:
     uint64_t size_in_bytes_;
     bool is_mutable_;
     bool temp_;
-    bool with_type_;
-    uint64_t item_size_;
+    bool with_type_ = false;
+    uint64_t item_size_ = 0;
     std::string data_type_;
     bool own_data_;
     uint64_t start_;
@@ -248,11 +231,5 @@ private:
 #ifdef RDC_USE_RDMA
     ibv_mr* memory_region_;
 #endif
-
-#ifdef RDC_USE_SHMEM
-    std::string memfile_name_;
-    std::shared_ptr<Shmem> shm_;
-    bool use_shm_;
-#endif
 };
 }  // namespace rdc
@@ -1,11 +1,16 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "common/status.h"
 #include "core/work_request.h"
 #include "transport/adapter.h"
 #include "transport/buffer.h"
 namespace rdc {
 const uint32_t kCommTimeoutMs = 600;
+/*! @brief tag of messages sent or received without one */
+const int32_t kDefaultTag = 0;
+/*! @brief a receive with this tag matches a message of any tag */
+const int32_t kAnyTag = -1;
 
 enum class ChannelKind : uint32_t {
     kRead,
@@ -26,6 +31,19 @@ public:
     virtual WorkCompletion* ISend(Buffer sendbuf) = 0;
 
     virtual WorkCompletion* IRecv(Buffer recvbuf) = 0;
+    /**
+     * @brief: tagged messages, a receive takes the oldest message with its
+     * tag, plain byte stream channels match by posting order only and so
+     * know nothing but the default tag
+     */
+    virtual WorkCompletion* ISend(Buffer sendbuf, const int32_t& tag);
+
+    virtual WorkCompletion* IRecv(Buffer recvbuf, const int32_t& tag);
+    /**
+     * @brief: send several buffers back to back as one batch, a stream
+     * channel may write them all with one call
+     */
+    virtual ChainWorkCompletion* ISendv(const std::vector<Buffer>& sendbufs);
 
     virtual void Close() = 0;
 
@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "common/pool.h"
+#include "transport/channel.h"
+
+namespace rdc {
+/*! @brief what a frame carries */
+enum class FrameType : uint32_t {
+    /*! a small message, its payload follows the header */
+    kEager,
+    /*! a large message asks to be sent, nothing follows */
+    kRts,
+    /*! the receive of a large message is posted, nothing follows */
+    kCts,
+    /*! the payload of a large message follows the header */
+    kData,
+};
+
+/*! @brief precedes every message on a framed channel */
+struct FrameHeader {
+    /*! kFrameMagic, catches a peer which does not speak frames */
+    uint32_t magic;
+    int32_t tag;
+    /*! hash of the name of the communicator which sent the message */
+    uint32_t comm_id;
+    FrameType type;
+    /*! size of the message, on every frame of it */
+    uint64_t length;
+    /*! pairs the rts, cts and data frames of one large message */
+    uint64_t seq;
+};
+
+/**
+ * @brief: tagged messages over a byte stream channel, every message is sent
+ * as a header followed by its payload, and a receive is matched by tag, not
+ * by posting order
+ *
+ * the channel always reads the next header itself, a message whose receive
+ * is posted lands in that buffer, any other is buffered in the unexpected
+ * queue until a receive with its tag is posted, messages with the same tag
+ * are taken in the order they were sent
+ *
+ * messages below the eager limit are copied behind their header into a
+ * bounce buffer of the channel and sent from there, their send is done once
+ * copied, larger ones first send a rts and only go out once the receiver
+ * answers with a cts, so that they land in the posted receive buffer
+ */
+class FramedChannel final : public IChannel {
+public:
+    FramedChannel(const std::shared_ptr<IChannel>& stream,
+                  const uint64_t& eager_limit);
+
+    virtual ~FramedChannel() override;
+
+    bool Connect(const std::string& hostname, const uint32_t& port) override;
+
+    WorkCompletion* ISend(Buffer sendbuf) override {
+        return ISend(sendbuf, kDefaultTag);
+    }
+
+    WorkCompletion* IRecv(Buffer recvbuf) override {
+        return IRecv(recvbuf, kDefaultTag);
+    }
+
+    WorkCompletion* ISend(Buffer sendbuf, const int32_t& tag) override;
+
+    WorkCompletion* IRecv(Buffer recvbuf, const int32_t& tag) override;
+
+    void Close() override;
+
+    /*! @brief largest eager limit whose messages fit a default pool arena */
+    static uint64_t max_eager_limit();
+
+private:
+    /*! @brief a receive posted before its message arrived */
+    struct PostedRecv {
+        int32_t tag;
+        Buffer recvbuf;
+        uint64_t req_id;
+    };
+    /*! @brief a large send waiting for its cts */
+    struct PendingSend {
+        Buffer sendbuf;
+        uint64_t req_id;
+    };
+    /*! @brief a message which arrived before its receive was posted */
+    struct Unexpected {
+        ~Unexpected() {
+            if (payload != nullptr) {
+                pool->deallocate(payload, header.length);
+            }
+        }
+        FrameHeader header;
+        /*! bounce buffer holding an eager payload, none for a rts */
+        std::shared_ptr<Pool> pool;
+        uint8_t* payload = nullptr;
+        /*! whether the whole payload is read */
+        bool arrived = false;
+        /*! a receive matched while the payload is still being read */
+        bool matched = false;
+        Buffer recvbuf;
+        uint64_t req_id = 0;
+    };
+    /**
+     * @brief: keep reading headers and payloads from the stream, handling
+     * whatever already arrived inline and returning once a read is pending
+     */
+    void Pump();
+    /*! @brief post the read for the current state, nullptr to stop */
+    WorkCompletion* PostRead();
+    /*! @brief handle a finished read, false to stop reading */
+    bool Advance(const WorkStatus& status);
+    /*! @brief act on a header which was read, false on a protocol error */
+    bool HandleHeader();
+    /*! @brief match an eager message against posted receives */
+    bool MatchEager();
+    /*! @brief match a rts against posted receives, answering a match */
+    bool MatchRts();
+    /*! @brief find the receive the payload of a large message goes to */
+    bool MatchData();
+    /*! @brief the payload of the current message is read */
+    void FinishPayload();
+    /**
+     * @brief: fail all posted and matched receives and the large sends with
+     * status, messages which arrived whole stay for later receives
+     */
+    void FailAll(const WorkStatus& status);
+    /**
+     * @brief: send a header with length bytes of payload copied behind it,
+     * or none when payload is null, the caller holds send_lock_
+     */
+    void SendFrame(const FrameType& type, const int32_t& tag,
+                   const uint64_t& length, const uint64_t& seq,
+                   const void* payload);
+    /*! @brief let the sender of a rts go on, its receive is posted */
+    void SendCts(const FrameHeader& rts);
+    /*! @brief send the payload of the large message asked for by a cts */
+    bool SendData(const uint64_t& seq);
+    /*! @brief copy a buffered message into recvbuf and finish req_id */
+    static void Deliver(const Unexpected& message, Buffer recvbuf,
+                        const uint64_t& req_id);
+
+    static bool TagMatches(const int32_t& posted_tag, const int32_t& tag) {
+        return posted_tag == kAnyTag || posted_tag == tag;
+    }
+
+    std::shared_ptr<IChannel> stream_;
+    uint32_t comm_id_;
+    uint64_t eager_limit_;
+    /**
+     * bounce buffers of frames, shared with the stream sends which return
+     * them once done, even after the channel is gone
+     */
+    std::shared_ptr<Pool> bounce_pool_;
+    /** keeps the header and the payload of a message together */
+    std::mutex send_lock_;
+    uint64_t next_seq_ = 0;
+    /** large sends waiting for their cts by seq, under send_lock_ */
+    std::unordered_map<uint64_t, PendingSend> pending_sends_;
+    /** guards the queues below and the current message */
+    std::mutex match_lock_;
+    std::deque<PostedRecv> posted_;
+    std::deque<std::shared_ptr<Unexpected>> unexpected_;
+    /** receives of large messages waiting for their data, by seq */
+    std::unordered_map<uint64_t, PostedRecv> awaiting_data_;
+    // state of the reader, only touched by the reading thread
+    bool reading_payload_ = false;
+    FrameHeader header_;
+    std::shared_ptr<Unexpected> cur_unexpected_;
+    /** posted receive the current payload goes to, under match_lock_ */
+    bool cur_posted_ = false;
+    uint64_t cur_req_id_ = 0;
+    Buffer cur_recvbuf_;
+    std::atomic<bool> closing_{false};
+};
+}  // namespace rdc
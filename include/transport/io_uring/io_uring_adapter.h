@@ -0,0 +1,83 @@
+#pragma once
+#include <linux/io_uring.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "transport/adapter.h"
+#include "transport/channel.h"
+#include "transport/io_uring/io_uring_channel.h"
+#include "transport/tcp/socket.h"
+
+namespace rdc {
+/**
+ * @class IoUringAdapter
+ * @brief governs tcp channels driven by one io_uring instance, the thread
+ * issuing a send or receive fills the submission and enters the kernel once,
+ * a poller thread sleeps until completions arrive and handles all of them
+ * in one pass, sockets are registered as fixed files when the kernel allows
+ */
+class IoUringAdapter : public IAdapter {
+public:
+    IoUringAdapter();
+    static IoUringAdapter* Get() {
+        static IoUringAdapter adapter;
+        return &adapter;
+    }
+    ~IoUringAdapter();
+
+    void Listen(const int& port) override;
+
+    IChannel* Accept() override;
+    /**
+     * @brief: put the socket of channel into the fixed file table
+     * @return its index, or -1 when the table is full or unsupported
+     */
+    int32_t AddChannel(IoUringChannel* channel);
+
+    void RemoveChannel(IoUringChannel* channel);
+    /**
+     * @brief: submit a send or receive of len bytes at addr on channel
+     */
+    void Submit(IoUringChannel* channel, const bool& is_recv, void* addr,
+                const uint32_t& len);
+
+private:
+    void SetupRing(const uint32_t& entries);
+
+    void PollForever();
+    /**
+     * @brief: handle all completions in the ring
+     * @return false once the shutdown marker is seen
+     */
+    bool Harvest();
+
+    int32_t ring_fd_;
+    // submission ring, shared with the kernel
+    uint32_t* sq_head_;
+    uint32_t* sq_tail_;
+    uint32_t* sq_array_;
+    uint32_t sq_mask_;
+    uint32_t sq_entries_;
+    io_uring_sqe* sqes_;
+    // completion ring, shared with the kernel
+    uint32_t* cq_head_;
+    uint32_t* cq_tail_;
+    uint32_t cq_mask_;
+    io_uring_cqe* cqes_;
+    // mappings to undo
+    void* sq_ptr_;
+    size_t sq_size_;
+    void* cq_ptr_;
+    size_t cq_size_;
+    size_t sqes_size_;
+    /** serializes filling and entering of submissions */
+    std::mutex submit_lock_;
+    /** free slots of the fixed file table, empty if there is no table */
+    std::vector<int32_t> free_files_;
+    std::mutex files_lock_;
+    TcpSocket listen_sock_;
+    std::unique_ptr<std::thread> poll_thrd_;
+};
+}  // namespace rdc
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include "core/work_request.h"
+#include "transport/channel.h"
+#include "transport/tcp/socket.h"
+
+namespace rdc {
+class IoUringAdapter;
+/**
+ * @brief: a tcp channel whose sends and receives are submitted to the
+ * io_uring of its adapter, each direction has at most one submission in
+ * flight, the head of its queue, so the stream is never reordered, short
+ * transfers are submitted again for the remaining bytes
+ */
+class IoUringChannel final : public IChannel {
+public:
+    IoUringChannel();
+    IoUringChannel(IoUringAdapter* adapter, const TcpSocket& sock);
+    virtual ~IoUringChannel() override;
+    bool Connect(const std::string& hostname, const uint32_t& port) override;
+    WorkCompletion* ISend(Buffer sendbuf) override;
+    WorkCompletion* IRecv(Buffer recvbuf) override;
+
+    void Close() override;
+    /**
+     * @brief: invoked by the poller of the adapter with the result of the
+     * submission of one direction
+     */
+    void OnCompletion(const bool& is_recv, const int32_t& res);
+
+    int sockfd() const {
+        return sock_.sockfd;
+    }
+    /** @brief: index in the fixed file table of the ring, -1 if none */
+    int32_t file_index() const {
+        return file_index_;
+    }
+
+private:
+    struct Direction {
+        std::mutex lock;
+        std::deque<uint64_t> reqs;
+        /** whether the head is submitted */
+        bool posted = false;
+    };
+    void Enqueue(const bool& is_recv, const uint64_t& req_id);
+    /** @brief submit the remaining bytes of the head, with its lock held */
+    void PostHead(const bool& is_recv);
+
+    Direction& direction(const bool& is_recv) {
+        return is_recv ? recv_ : send_;
+    }
+
+    TcpSocket sock_;
+    IoUringAdapter* adapter_;
+    int32_t file_index_;
+    Direction send_;
+    Direction recv_;
+    /** submissions whose completions are not harvested yet */
+    std::atomic<int32_t> inflight_{0};
+    std::atomic<bool> closing_{false};
+};
+}  // namespace rdc
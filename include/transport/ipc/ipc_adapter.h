@@ -1,62 +1,60 @@
 #pragma once
-#include <algorithm>
-#include <functional>
-#include <thread>
-#include <unordered_map>
-#include <vector>
+#include <string>
 #include "transport/adapter.h"
 #include "transport/channel.h"
 #include "transport/ipc/ipc_channel.h"
-#include "utils/lock_utils.h"
-
-bool operator==(const std::tuple<int, int>& lhs,
-                const std::tuple<int, int>& rhs) {
-    return (std::get<0>(lhs) == std::get<0>(rhs)) &&
-           (std::get<1>(lhs) == std::get<1>(rhs));
-}
-
-namespace std {
-template <>
-struct hash<std::tuple<int, int>> {
-    typedef std::tuple<int, int> argument_type;
-    typedef std::size_t result_type;
-    result_type operator()(argument_type const& s) const noexcept {
-        result_type const h1(std::hash<int>{}(std::get<0>(s)));
-        result_type const h2(std::hash<int>{}(std::get<1>(s)));
-        return h1 ^ (h2 << 1);  // or use boost::hash_combine
-    }
-};
-}  // namespace std
 
 namespace rdc {
 /**
  * @class IpcAdapter
- * @brief tcpadapther which will govern all tcp connections
+ * @brief ipcadapter which governs all channels between processes on the same
+ * host, no listening is needed since both ends of a channel find their
+ * shared memory segment by name
  */
 class IpcAdapter : public IAdapter {
 public:
     IpcAdapter();
     static IpcAdapter* Get();
 
-    ~IpcAdapter();
-
-    void Shutdown();
+    ~IpcAdapter() = default;
 
     void Listen(const int& port) override;
 
     IChannel* Accept() override;
-
-    void SetPrivData(int rank, int peer_rank,
-                     char priv_data[kMemFileNameSize]);
-
-    void GetPrivData(int rank, int peer_rank,
-                     char priv_data[kMemFileNameSize]);
-
-    void ComputePrivateDataLocations();
+    /**
+     * @brief: name of the segment shared by two ranks in a communicator,
+     * unique per job
+     */
+    std::string SegmentName(const std::string& comm, const int& rank,
+                            const int& peer_rank) const;
+    /**
+     * @brief: name of the arena shared by all ranks of a communicator which
+     * live on one host
+     */
+    std::string ArenaName(const std::string& comm) const;
+    /** @brief: capacity in bytes of every ring, a power of two */
+    uint64_t ring_capacity() const {
+        return ring_capacity_;
+    }
+    /**
+     * @brief: messages of at least this many bytes are pulled by the receiver
+     * straight from the sender's memory, zero disables it
+     */
+    uint64_t rndv_threshold() const {
+        return rndv_threshold_;
+    }
+    /**
+     * @brief: bytes every rank contributes to one round of a shared memory
+     * collective, zero disables them
+     */
+    uint64_t coll_slot_size() const {
+        return coll_slot_size_;
+    }
 
 private:
-    std::unordered_map<std::tuple<int, int>, int> priv_data_locs_;
-    std::unique_ptr<Shmem> priv_data_;
+    uint64_t ring_capacity_;
+    uint64_t rndv_threshold_;
+    uint64_t coll_slot_size_;
 };
 
 }  // namespace rdc
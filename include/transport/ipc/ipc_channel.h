@@ -1,15 +1,29 @@
 #pragma once
 #include <unistd.h>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "common/threadsafe_queue.h"
 #include "core/work_request.h"
 #include "transport/channel.h"
+#include "transport/ipc/shm.h"
+#include "transport/ipc/shm_ring.h"
+#include "utils/lock_utils.h"
 
 namespace rdc {
-const int kMemFileNameSize = 8;
 class IpcAdapter;
 /**
- * @brief: a channel which send and recv data on tcp protocal and ethernet
+ * @brief: a channel between two processes on the same host, backed by a
+ * shared memory segment holding one ring per direction, the segment is
+ * created by the lower rank when the channel is first used and kept until
+ * the channel is closed
+ *
+ * messages of at least the rendezvous threshold are not copied through the
+ * ring, the sender only writes a descriptor of its buffer and the receiver
+ * reads the bytes straight out of the sender with process_vm_readv, both
+ * ends tell such messages apart by size, so a send and its matching receive
+ * must have the same size
  */
 class IpcChannel final : public IChannel {
 public:
@@ -27,8 +41,49 @@ public:
     }
 
 private:
-    int send_counter_;
-    int recv_counter_;
+    /**
+     * @brief: create or open the segment shared with the peer and start the
+     * progress threads, comm and peer rank must be set before
+     */
+    bool Attach();
+    /*! @brief drive queued sends which did not fit into the ring */
+    void SendLoop();
+    /*! @brief drive queued receives which found the ring empty */
+    void RecvLoop();
+    bool IsLarge(const uint64_t& nbytes) const {
+        return rndv_threshold_ != 0 && nbytes >= rndv_threshold_;
+    }
+    /**
+     * @brief: block until all bytes went through the ring or the channel
+     * is closing
+     */
+    bool WriteAll(const void* data, const uint64_t& nbytes);
+    bool ReadAll(void* data, const uint64_t& nbytes);
+    /*! @brief send a message above the threshold, from the send thread */
+    bool SendLarge(WorkRequest& send_req);
+    /*! @brief receive a message above the threshold, from the recv thread */
+    bool RecvLarge(WorkRequest& recv_req);
+
+    std::unique_ptr<Shm> shm_;
+    ShmRing send_ring_;
+    ShmRing recv_ring_;
+    std::mutex attach_lock_;
+    std::atomic<bool> attached_{false};
+    /** taken from the creator of the segment so that both ends agree */
+    uint64_t rndv_threshold_ = 0;
+    /** rendezvous sent so far, only touched by the send thread */
+    uint32_t rndv_count_ = 0;
+    /** set once the peer could not read our memory */
+    bool rndv_refused_ = false;
+    // requests which could not complete right away, served in order
+    ThreadsafeQueue<uint64_t> send_reqs_;
+    ThreadsafeQueue<uint64_t> recv_reqs_;
+    /** guards emptiness checks of the queues against concurrent pops */
+    utils::SpinLock send_lock_;
+    utils::SpinLock recv_lock_;
+    std::thread send_thrd_;
+    std::thread recv_thrd_;
+    std::atomic<bool> closing_{false};
     /** only used to enable accept and listen callbacks */
     IpcAdapter* adapter_;
 };
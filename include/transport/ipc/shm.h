@@ -36,7 +36,8 @@ public:
     };
 
     /**
-     * @brief: open an existing shared memory for reading
+     * @brief: open an existing shared memory for reading and writing, fails
+     * until its creator has sized it
      *
      * @return error indicates whether opening is successful
      */
@@ -53,6 +54,10 @@ public:
     inline uint8_t* Data() {
         return data_;
     }
+    /**
+     * @brief: remove the name of the shared memory, mappings stay valid
+     */
+    void Unlink();
 
     ~Shm();
 
@@ -62,10 +67,11 @@ private:
     std::string path_;
     uint8_t* data_ = nullptr;
     size_t size_ = 0;
+    bool created_ = false;
 #if defined(_WIN32)
     HANDLE handle_;
 #else
     int fd_ = -1;
 #endif
 };
-}  // namespace shoom
+}  // namespace rdc
@@ -0,0 +1,109 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file shm_ring.h
+ * \brief a single producer single consumer byte ring living in shared
+ *  memory, one per direction of an ipc channel
+ *
+ *  head and tail count all bytes ever written and read, so the ring is full
+ *  when they are capacity apart and no slot is wasted, each side only
+ *  writes its own index, an idle side sleeps on a futex which is rung by
+ *  the other side after it moves its index
+ *
+ *  the consumer also answers rendezvous requests read from the ring through
+ *  a reply slot, the producer has at most one of them in flight
+ *
+ * \author Ankun Zheng
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace rdc {
+struct ShmRingHeader {
+    /*! @brief bytes written so far, only moved by the producer */
+    alignas(64) std::atomic<uint64_t> head;
+    /*! @brief doorbell rung by the producer after head moved */
+    std::atomic<uint32_t> data_seq;
+    std::atomic<uint32_t> data_waiters;
+    /*! @brief bytes read so far, only moved by the consumer */
+    alignas(64) std::atomic<uint64_t> tail;
+    /*! @brief doorbell rung by the consumer after tail moved */
+    std::atomic<uint32_t> space_seq;
+    std::atomic<uint32_t> space_waiters;
+    /*! @brief number of rendezvous answered, the last answer is in reply */
+    alignas(64) std::atomic<uint32_t> reply_seq;
+    std::atomic<uint32_t> reply_waiters;
+    std::atomic<uint32_t> reply;
+};
+
+class ShmRing {
+public:
+    ShmRing() = default;
+    /**
+     * @brief: bytes taken by a ring with the given capacity
+     */
+    static uint64_t SizeOf(const uint64_t& capacity) {
+        return sizeof(ShmRingHeader) + capacity;
+    }
+    /**
+     * @brief: use the ring laid out at addr
+     *
+     * @param capacity size of the data area, a power of two
+     * @param init whether to reset the indices, done once by the creator
+     */
+    void Attach(void* addr, const uint64_t& capacity, const bool& init);
+    /**
+     * @brief: copy as many bytes of data as fit, never blocks
+     *
+     * @return number of bytes written
+     */
+    uint64_t TryWrite(const void* data, const uint64_t& nbytes);
+    /**
+     * @brief: copy as many bytes as are available into data, never blocks
+     *
+     * @return number of bytes read
+     */
+    uint64_t TryRead(void* data, const uint64_t& nbytes);
+    /**
+     * @brief: block until something can be read or the timeout expires,
+     * spins shortly before sleeping
+     */
+    void WaitReadable(const int& timeout_ms);
+    /**
+     * @brief: block until something can be written or the timeout expires
+     */
+    void WaitWritable(const int& timeout_ms);
+    /**
+     * @brief: answer the oldest unanswered rendezvous, done by the consumer
+     */
+    void Reply(const uint32_t& reply);
+    /**
+     * @brief: block until the count-th rendezvous is answered or the timeout
+     * expires
+     *
+     * @return whether it is answered
+     */
+    bool WaitReply(const uint32_t& count, const int& timeout_ms);
+    /** @brief: answer of the last rendezvous */
+    uint32_t reply() const {
+        return header_->reply.load(std::memory_order_acquire);
+    }
+    /**
+     * @brief: wake whoever sleeps on this ring, used when closing
+     */
+    void Wake();
+
+    uint64_t readable() const;
+
+    uint64_t writable() const;
+
+    uint64_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    ShmRingHeader* header_ = nullptr;
+    uint8_t* data_ = nullptr;
+    uint64_t capacity_ = 0;
+};
+}  // namespace rdc
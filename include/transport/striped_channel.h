@@ -0,0 +1,49 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "transport/channel.h"
+
+namespace rdc {
+/**
+ * @brief: one link to a peer made of several connected channels, the stripes,
+ * so that a single tcp flow does not cap its bandwidth
+ *
+ * messages of at least threshold bytes are cut into one contiguous part per
+ * stripe, smaller ones go over the first stripe, both ends cut the same way
+ * since a receive is always posted with the size of its send, and parts of
+ * one message are posted to all stripes before the next message is
+ */
+class StripedChannel final : public IChannel {
+public:
+    StripedChannel(const std::vector<std::shared_ptr<IChannel>>& stripes,
+                   const uint64_t& threshold);
+
+    virtual ~StripedChannel() override;
+    /** @brief: connect every stripe to the same peer */
+    bool Connect(const std::string& hostname, const uint32_t& port) override;
+
+    WorkCompletion* ISend(Buffer sendbuf) override;
+
+    WorkCompletion* IRecv(Buffer recvbuf) override;
+
+    void Close() override;
+
+    int32_t num_stripes() const {
+        return static_cast<int32_t>(stripes_.size());
+    }
+
+private:
+    /**
+     * @brief: post buf over the stripes, the returned completion is done once
+     * all parts are done
+     */
+    WorkCompletion* Post(const bool& is_recv, Buffer buf);
+
+    std::vector<std::shared_ptr<IChannel>> stripes_;
+    uint64_t threshold_;
+    /** keep the parts of one message together on every stripe */
+    std::mutex send_lock_;
+    std::mutex recv_lock_;
+};
+}  // namespace rdc
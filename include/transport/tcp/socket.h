@@ -14,6 +14,7 @@
 #include <sys/ioctl.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 #include <cstring>
@@ -192,6 +193,26 @@ public:
      *         return -1 if error occurs
      */
     ssize_t Recv(void *buf_, size_t len, int flags = 0);
+#if !defined(_WIN32)
+    /*!
+     * @brief send several buffers with one gathered write
+     * @param iov the buffers
+     * @param iovcnt the number of buffers
+     * @param flags extra flags
+     * @return size of data actually sent
+     *         return -1 if error occurs
+     */
+    ssize_t SendV(const struct iovec *iov, int iovcnt, int flags = 0);
+    /*!
+     * @brief receive into several buffers with one scattered read, each
+     *    filled up before the next
+     * @param iov the buffers
+     * @param iovcnt the number of buffers
+     * @return size of data actually received
+     *         return -1 if error occurs
+     */
+    ssize_t RecvV(const struct iovec *iov, int iovcnt);
+#endif
     /*!
      * @brief peform block write that will attempt to send all data out
      *    can still return smaller than request when error occurs
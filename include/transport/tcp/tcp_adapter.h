@@ -1,6 +1,8 @@
 #pragma once
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -10,9 +12,21 @@
 #include "utils/lock_utils.h"
 
 namespace rdc {
+/**
+ * @brief: an epoll instance polled by its own thread, with the channels
+ * assigned to it
+ */
+struct TcpPollerShard {
+    int32_t epoll_fd;
+    std::unordered_map<int, TcpChannel*> channels;
+    std::mutex lock;
+    std::unique_ptr<std::thread> thrd;
+};
 /**
  * @class TcpAdapter
- * @brief tcpadapther which will govern all tcp connections
+ * @brief tcpadapther which will govern all tcp connections, channels are
+ * spread over RDC_TCP_NUM_POLLERS shards by their fd, so that each shard
+ * is polled by a thread of its own
  */
 class TcpAdapter : public IAdapter {
 public:
@@ -21,7 +35,6 @@ public:
         static TcpAdapter poller;
         return &poller;
     }
-    std::unordered_map<int, TcpChannel*> channels_;
     ~TcpAdapter();
 
     void AddChannel(int fd, TcpChannel* channel);
@@ -36,14 +49,34 @@ public:
 
     void PollForever();
 
-    bool Poll();
+    /*!
+     * @brief process the events of one shard once
+     * @return whether polling of the shard is finished
+     */
+    bool Poll(TcpPollerShard& shard);
 
     void Listen(const int& port);
 
     IChannel* Accept() override;
 
-    int32_t epoll_fd() const {
-        return epoll_fd_;
+    /**
+     * @brief: whether channels are registered edge triggered, then pollers
+     * drain sockets themselves instead of handing events to the thread pool
+     */
+    bool edge_triggered() const {
+        return edge_triggered_;
+    }
+
+    /**
+     * @brief: sends of at least this many bytes use MSG_ZEROCOPY, 0 when
+     * zero copy is off
+     */
+    uint64_t zerocopy_threshold() const {
+        return zerocopy_threshold_;
+    }
+
+    int32_t num_pollers() const {
+        return static_cast<int32_t>(shards_.size());
     }
 
     bool shutdown() const {
@@ -62,17 +95,21 @@ public:
 private:
     /** timeout duration */
     int32_t timeout_;
-    /** epoll file descriptor*/
-    int32_t epoll_fd_;
+    TcpPollerShard& ShardOf(const int32_t& fd) {
+        return *shards_[fd % shards_.size()];
+    }
+    /** shards of channels, one epoll fd and poller thread each */
+    std::vector<std::unique_ptr<TcpPollerShard>> shards_;
+    /** first core to pin poller threads to, -1 leaves them unpinned */
+    int32_t first_poller_core_;
+    bool edge_triggered_;
+    uint64_t zerocopy_threshold_;
     int32_t shutdown_fd_;
     TcpSocket listen_sock_;
 
     std::atomic<bool> shutdown_;
     std::atomic<bool> shutdown_called_;
-    // utils::SpinLock lock_;
-    std::mutex lock_;
     std::mutex shutdown_lock_;
-    std::unique_ptr<std::thread> loop_thrd;
     std::unique_ptr<std::thread> listen_thrd;
 };
 
@@ -1,6 +1,10 @@
 #pragma once
 #include <unistd.h>
 #include <atomic>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include "common/threadsafe_queue.h"
 #include "core/work_request.h"
 #include "transport/channel.h"
@@ -23,11 +27,44 @@ public:
     bool Connect(const std::string& hostname, const uint32_t& port) override;
     WorkCompletion* ISend(Buffer sendbuf) override;
     WorkCompletion* IRecv(Buffer recvbuf) override;
+    /**
+     * @brief: queue all buffers at once, so that they leave in one gathered
+     * write unless earlier sends are still queued
+     */
+    ChainWorkCompletion* ISendv(const std::vector<Buffer>& sendbufs) override;
 
     void Close() override;
 
     void ReadCallback();
     void WriteCallback();
+    /**
+     * @brief: edge triggered mode, receive into posted requests until the
+     * socket runs dry or no request is left, on the calling thread
+     */
+    void DrainRecv();
+    /**
+     * @brief: edge triggered mode, send queued requests until the socket is
+     * full or the queue is empty, on the calling thread
+     */
+    void DrainSend();
+
+    /**
+     * @brief: send requests of at least threshold bytes with MSG_ZEROCOPY,
+     * they finish once the kernel releases their pages, not once written
+     */
+    void EnableZeroCopy(const uint64_t& threshold) {
+        zerocopy_threshold_ = threshold;
+    }
+
+    bool zerocopy() const {
+        return zerocopy_threshold_ != 0;
+    }
+    /**
+     * @brief: read zero copy notifications off the error queue of the
+     * socket and finish the sends whose pages are released
+     * @return false if the queue held a real error
+     */
+    bool ReapZeroCopy();
 
     void AddEventOfInterest(const ChannelKind& kind);
     void DeleteEventOfInterest(const ChannelKind& kind);
@@ -44,6 +81,44 @@ public:
         return sock_.sockfd;
     }
 private:
+    bool edge_triggered() const;
+    /** @brief send the rest of the head send request, maybe zero copy */
+    ssize_t SendHead(WorkRequest& send_req);
+    /**
+     * @brief: write queued sends from the head on with one gathered write,
+     * the head alone if it goes zero copy, and pop the ones written whole,
+     * those not waiting for zero copy pages are added to done_reqs
+     * @return bytes written, -1 on failure with errno set
+     */
+    ssize_t SendQueued(std::vector<uint64_t>* done_reqs);
+    /**
+     * @brief: read into posted receives from the head on with one scattered
+     * read, and pop the ones filled up into done_reqs
+     * @return bytes read, -1 on failure with errno set
+     */
+    ssize_t RecvQueued(std::vector<uint64_t>* done_reqs);
+    /**
+     * @brief: credit nbytes moved by one call to the first num_reqs of
+     * req_ids in order
+     * @return how many of them are complete now, all before the first one
+     * which is not
+     */
+    static size_t Credit(const std::vector<uint64_t>& req_ids,
+                         const size_t& num_reqs, const size_t& nbytes);
+    /**
+     * @brief: called once all bytes of a send are written and it is off the
+     * queue, keep it until its zero copy pages are released
+     * @return false if it is finished now
+     */
+    bool HoldZeroCopy(const uint64_t& send_req_id, const bool& zerocopy,
+                      const uint32_t& zerocopy_id);
+    /**
+     * @brief: set the final status of requests already off their queue and
+     * run their done callbacks, called with no drain lock held
+     */
+    static void Finish(const std::vector<uint64_t>& req_ids,
+                       const WorkStatus& status);
+
     TcpSocket sock_;
     // send recv request queue
     ThreadsafeQueue<uint64_t> send_reqs_;
@@ -51,6 +126,25 @@ private:
     /** only used to enable accept and listen callbacks */
     TcpAdapter* adapter_;
     utils::SpinLock mu_;
+    /** guards emptiness checks of send_reqs_ against concurrent pops */
+    utils::SpinLock send_lock_;
+    /** serialize drains of the poller and of the posting thread, the send
+     * one also keeps inline writes and the write callback apart, requests
+     * done meanwhile are finished once they are released */
+    std::mutex recv_drain_lock_;
+    std::mutex send_drain_lock_;
     std::atomic<bool> closing_{false};
+    /** 0 when zero copy sends are off */
+    uint64_t zerocopy_threshold_ = 0;
+    /** id the kernel gives to the next zero copy send */
+    uint32_t zerocopy_next_id_ = 0;
+    /** last zero copy id of the head send request, valid if it has one */
+    uint32_t head_zerocopy_id_ = 0;
+    bool head_zerocopy_ = false;
+    /** written sends waiting for their last zero copy id to be released */
+    std::deque<std::pair<uint32_t, uint64_t>> zerocopy_reqs_;
+    /** all ids before this one are released */
+    uint32_t zerocopy_released_ = 0;
+    std::mutex zerocopy_lock_;
 };
 }  // namespace rdc
@@ -1,6 +1,8 @@
 #pragma once
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <tuple>
 #include <vector>
 #include <unordered_map>
 namespace rdc {
@@ -22,4 +24,21 @@ std::tuple<std::unordered_map<int, std::vector<int>>,
            std::unordered_map<int, int>,
            std::unordered_map<int, std::pair<int, int>>>
 GetLinkMap(const uint32_t& num_workers);
+
+/*!
+ * @brief parent and children of rank in a binary tree rooted at rank 0, the
+ * tree is built on the binary representation of ranks so that all odd ranks
+ * are leaves, parent is -1 for the root
+ */
+std::tuple<int, std::vector<int>> GetBtree(const int& rank,
+                                           const uint32_t& num_workers);
+
+/*!
+ * @brief parent and children of rank in two complementary binary trees, the
+ * second tree is the first one shifted by one rank when num_workers is odd
+ * and mirrored otherwise, so every rank which is a leaf in one tree is an
+ * interior node in the other one
+ */
+std::vector<std::tuple<int, std::vector<int>>> GetDoubleTree(
+    const int& rank, const uint32_t& num_workers);
 }  // namespace rdc
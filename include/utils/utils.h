@@ -5,7 +5,9 @@
  * \author Ankun Zheng
  */
 #pragma once
+#include <algorithm>
 #include <cstdarg>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -48,6 +50,11 @@ inline const char* BeginPtr(const std::string& str) {
         return nullptr;
     return &str[0];
 }
+/*! \brief whether value is an element of vec */
+template <typename T>
+inline bool In(const T& value, const std::vector<T>& vec) {
+    return std::find(vec.begin(), vec.end(), value) != vec.end();
+}
 inline void* IncrVoidPtr(void* ptr, size_t step) {
     return reinterpret_cast<void*>(reinterpret_cast<int8_t*>(ptr) + step);
 }
@@ -56,14 +63,16 @@ inline const void* IncrConstVoidPtr(const void* ptr, size_t step) {
         reinterpret_cast<int8_t*>(const_cast<void*>(ptr)) + step);
 }
 /*! divide a range approximately into equally parts */
-inline std::vector<std::pair<int, int>> Split(int begin, int end, int nparts) {
-    std::vector<std::pair<int, int>> ranges(nparts);
-    int len = end - begin;
-    int k = len / nparts;
-    int m = len % nparts;
-    for (int i = 0; i < nparts; i++) {
-        int rbegin = begin + i * k + std::min(i, m);
-        int rend = begin + (i + 1) * k + std::min(i + 1, m);
+inline std::vector<std::pair<uint64_t, uint64_t>> Split(uint64_t begin,
+                                                        uint64_t end,
+                                                        uint64_t nparts) {
+    std::vector<std::pair<uint64_t, uint64_t>> ranges(nparts);
+    uint64_t len = end - begin;
+    uint64_t k = len / nparts;
+    uint64_t m = len % nparts;
+    for (uint64_t i = 0; i < nparts; i++) {
+        uint64_t rbegin = begin + i * k + std::min(i, m);
+        uint64_t rend = begin + (i + 1) * k + std::min(i + 1, m);
         ranges[i] = std::make_pair(rbegin, rend);
     }
     return ranges;
@@ -20,11 +20,36 @@ typedef CommunicatorRobust Comm;
 typedef Communicator Comm;
 #endif
 
+// whether an allreduce is sent as bfloat16, bitwise or has no meaning on it
+inline bool UseBFloat16Wire(const mpi::DataType& dtype,
+                            const mpi::OpType& op) {
+    return CommunicatorManager::Get()->allreduce_bf16_wire() &&
+           dtype == mpi::kFloat && op != mpi::kBitwiseOR;
+}
+
 // perform in-place allreduce, on sendrecvbuf
 void Allreduce_(Buffer sendrecvbuf, ReduceFunction red, mpi::DataType dtype,
                 mpi::OpType op, const std::string& name) {
-    CommunicatorManager::Get()->GetCommunicator(name)->Allreduce(sendrecvbuf,
-                                                                 red);
+    auto comm = CommunicatorManager::Get()->GetCommunicator(name);
+    if (UseBFloat16Wire(dtype, op)) {
+        return static_cast<Comm*>(comm)->AllreduceBFloat16(sendrecvbuf, op);
+    }
+    comm->Allreduce(sendrecvbuf, red);
+}
+
+WorkCompletion* IAllreduce_(Buffer sendrecvbuf, ReduceFunction red,
+                            mpi::DataType dtype, mpi::OpType op,
+                            const std::string& name) {
+    auto manager = CommunicatorManager::Get();
+    if (sendrecvbuf.size_in_bytes() <= manager->fusion_threshold()) {
+        return manager->fusion_buffer()->Add(name, sendrecvbuf, red, dtype,
+                                             op);
+    }
+    auto comm = manager->GetCommunicator(name);
+    if (UseBFloat16Wire(dtype, op)) {
+        return static_cast<Comm*>(comm)->IAllreduceBFloat16(sendrecvbuf, op);
+    }
+    return comm->IAllreduce(sendrecvbuf, red);
 }
 
 }  // namespace comm
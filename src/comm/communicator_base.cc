@@ -6,15 +6,20 @@
  * \author Ankun Zheng
  */
 #include "comm/communicator_base.h"
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <map>
+#include <mutex>
+#include <vector>
 #include "common/env.h"
 #include "common/threadpool.h"
 #include "core/logging.h"
 #include "sys/error.h"
 #include "sys/network.h"
 #include "transport/channel.h"
+#include "transport/framed_channel.h"
+#include "transport/striped_channel.h"
 #include "utils/string_utils.h"
 #include "utils/topo_utils.h"
 #ifdef RDC_USE_RDMA
@@ -24,9 +29,27 @@
 #include "transport/ipc/ipc_adapter.h"
 #include "transport/ipc/ipc_channel.h"
 #endif
+#ifdef RDC_USE_IO_URING
+#include "transport/io_uring/io_uring_channel.h"
+#endif
 #include "core/exception.h"
 namespace rdc {
 namespace comm {
+namespace {
+// one flow per peer unless asked, striping needs the same value everywhere
+const int32_t kDefaultNumStripes = 1;
+const uint64_t kDefaultStripeThreshold = 1 << 18;
+const uint64_t kDefaultEagerLimit = 8 << 10;
+/*! @brief channel to a peer reached over tcp, driven by the chosen adapter */
+IChannel* NewTcpChannel() {
+#ifdef RDC_USE_IO_URING
+    if (GetAdapter()->backend() == kIoUring) {
+        return new IoUringChannel;
+    }
+#endif
+    return new TcpChannel;
+}
+}  // namespace
 // constructor
 Communicator::Communicator(const std::string& name) {
     name_ = name;
@@ -35,6 +58,13 @@ Communicator::Communicator(const std::string& name) {
     err_link = nullptr;
     children_counter_ = 0;
     is_main_comm_ = true;
+    reduce_scratch_ = nullptr;
+    reduce_scratch_size_ = 0;
+    wire_scratch_ = nullptr;
+    wire_scratch_size_ = 0;
+#ifdef RDC_USE_SHMEM
+    shm_collective_probed_ = false;
+#endif
 }
 Communicator::Communicator() : Communicator(kMainCommName) {
 }
@@ -44,9 +74,20 @@ Communicator::Communicator(const Communicator& other) {
     parent_rank_ = other.parent_rank_;
     tree_map_ = other.tree_map_;
     is_main_comm_ = false;
+    reduce_scratch_ = nullptr;
+    reduce_scratch_size_ = 0;
+    wire_scratch_ = nullptr;
+    wire_scratch_size_ = 0;
+#ifdef RDC_USE_SHMEM
+    shm_collective_probed_ = false;
+#endif
 }
 
 Communicator::~Communicator() {
+    // finish queued collectives before the scratch space goes away
+    progress_pool_.reset();
+    utils::Free(reduce_scratch_);
+    utils::Free(wire_scratch_);
 }
 // initialization function
 void Communicator::Init(int world_size, int num_conn, int num_accept) {
@@ -68,6 +109,7 @@ void Communicator::Register() {
 
 void Communicator::Shutdown() {
     // notify tracker rank i have shutdown
+    this->WaitCollectives();
     this->ResetLinks();
     this->Barrier();
     Tracker::Get()->Lock();
@@ -161,6 +203,11 @@ void Communicator::ResetLinks() {
  */
 void Communicator::ReConnectLinks(const std::tuple<int, int>& num_conn_accept) {
     this->BuildTopology(GetWorldSize());
+    host_leaders_.clear();
+#ifdef RDC_USE_SHMEM
+    shm_collective_.reset();
+    shm_collective_probed_ = false;
+#endif
     this->Register();
     this->Exclude();
     int num_conn = 0, num_accept = 0;
@@ -169,54 +216,103 @@ void Communicator::ReConnectLinks(const std::tuple<int, int>& num_conn_accept) {
 #ifdef RDC_USE_SHMEM
     auto&& peers_with_same_host = Tracker::Get()->peers_with_same_host();
 #endif
+    // several tcp connections per peer, each a stripe of one link
+    const int32_t num_stripes = std::max(
+        Env::Get()->GetEnv("RDC_TCP_NUM_STRIPES", kDefaultNumStripes), 1);
+    const uint64_t stripe_threshold = Env::Get()->GetEnv(
+        "RDC_TCP_STRIPE_THRESHOLD", kDefaultStripeThreshold);
+    std::mutex stripes_lock;
+    std::map<int, std::vector<std::shared_ptr<IChannel>>> accepted_stripes;
+    // tagged messages over tcp links, every node must agree on it
+    const bool framed = Env::Get()->GetEnv("RDC_TCP_FRAMED", 0) != 0;
+    // smaller messages skip the rts/cts handshake of framed links
+    uint64_t eager_limit =
+        Env::Get()->GetEnv("RDC_TCP_EAGER_LIMIT", kDefaultEagerLimit);
+    if (eager_limit > FramedChannel::max_eager_limit()) {
+        LOG_F(WARNING, "RDC_TCP_EAGER_LIMIT is larger than a bounce buffer, "
+                       "clamp it to %lu bytes",
+              FramedChannel::max_eager_limit());
+        eager_limit = FramedChannel::max_eager_limit();
+    }
     try {
         for (int i = 0; i < num_conn; i++) {
             std::string haddr = Tracker::Get()->peer_addr(i);
             int hrank = Tracker::Get()->peer_conn(i);
+            bool over_tcp = GetAdapter()->backend() != kRdma;
+#ifdef RDC_USE_SHMEM
+            over_tcp = over_tcp && !utils::In(hrank, peers_with_same_host);
+#endif
+            const int32_t num_links = over_tcp ? num_stripes : 1;
+            const bool framed_link = framed && over_tcp;
             std::shared_ptr<IChannel> channel;
 #ifdef RDC_USE_RDMA
             if (GetAdapter()->backend() == kRdma) {
                 channel.reset(new RdmaChannel);
             } else {
-#if RDC_USE_SHMEM
+#ifdef RDC_USE_SHMEM
                 if (utils::In(hrank, peers_with_same_host)) {
                     channel.reset(new IpcChannel);
                 } else {
-                    channel.reset(new TcpChannel);
+                    channel.reset(NewTcpChannel());
                 }
 #else
-                channel.reset(new TcpChannel);
+                channel.reset(NewTcpChannel());
 #endif
             }
 ///////////////////////////////////////////////////////////////////////////////
 #else
-#if RDC_WITH_SHMEM
+#ifdef RDC_USE_SHMEM
             if (utils::In(hrank, peers_with_same_host)) {
                 channel.reset(new IpcChannel);
             } else {
-                channel.reset(new TcpChannel);
+                channel.reset(NewTcpChannel());
             }
 #else
-            channel.reset(new TcpChannel);
+            channel.reset(NewTcpChannel());
 #endif
 #endif
             channel->set_comm(name_);
             channel->set_peer_rank(hrank);
             LOG_F(INFO, "Node %d id trying to connect to node %d with address %s",
                   GetRank(), hrank, haddr.c_str());
-            pool.AddTask([this, &channel, haddr, hrank] {
-                if (channel->Connect(haddr) != true) {
-                    LOG_F(INFO, "%d %d", GetRank(), hrank);
-                    channel->Close();
-                    LOG_F(ERROR, "Connect Error");
-                    return;
-                } else {
-                    int hrank = 0;
-                    LOG_F(INFO, "%d %d", GetRank(), hrank);
-                    CHECK_F(channel->RecvInt(hrank) == WorkStatus::kFinished,
+            pool.AddTask([this, &channel, haddr, hrank, num_links,
+                          stripe_threshold, framed_link, eager_limit] {
+                std::vector<std::shared_ptr<IChannel>> stripes;
+                for (int32_t s = 0; s < num_links; s++) {
+                    auto stripe = channel;
+                    if (s != 0) {
+                        stripe.reset(NewTcpChannel());
+                        stripe->set_comm(name_);
+                        stripe->set_peer_rank(hrank);
+                    }
+                    if (stripe->Connect(haddr) != true) {
+                        LOG_F(INFO, "%d %d", GetRank(), hrank);
+                        stripe->Close();
+                        LOG_F(ERROR, "Connect Error");
+                        return;
+                    } else {
+                        int hrank = 0;
+                        LOG_F(INFO, "%d %d", GetRank(), hrank);
+                        CHECK_F(
+                            stripe->RecvInt(hrank) == WorkStatus::kFinished,
                             "Reconnect Link failure");
-                    channel->SendInt(GetRank());
-                    LOG_F(INFO, "%d %d", GetRank(), hrank);
+                        stripe->SendInt(GetRank());
+                        if (num_links > 1) {
+                            stripe->SendInt(s);
+                        }
+                        LOG_F(INFO, "%d %d", GetRank(), hrank);
+                    }
+                    stripes.emplace_back(stripe);
+                }
+                if (num_links > 1) {
+                    channel = std::make_shared<StripedChannel>(
+                        stripes, stripe_threshold);
+                    channel->set_comm(name_);
+                    channel->set_peer_rank(hrank);
+                }
+                if (framed_link) {
+                    channel =
+                        std::make_shared<FramedChannel>(channel, eager_limit);
                 }
                 all_links_[hrank] = channel;
             });
@@ -224,11 +320,20 @@ void Communicator::ReConnectLinks(const std::tuple<int, int>& num_conn_accept) {
         }
         // listen to incoming links
         for (int i = 0; i < num_accept; ++i) {
-            pool.AddTask([this, i]() {
+#ifdef RDC_USE_SHMEM
+            pool.AddTask([this, i, &peers_with_same_host, num_stripes,
+                          stripe_threshold, framed, eager_limit,
+                          &stripes_lock, &accepted_stripes]() {
+#else
+            pool.AddTask([this, i, num_stripes, stripe_threshold, framed,
+                          eager_limit, &stripes_lock, &accepted_stripes]() {
+#endif
                 auto hrank = Tracker::Get()->peer_accept(i);
                 IChannel* channel = nullptr;
-#if RDC_WITH_SHMEM
+                bool over_tcp = GetAdapter()->backend() != kRdma;
+#ifdef RDC_USE_SHMEM
                 if (utils::In(hrank, peers_with_same_host)) {
+                    over_tcp = false;
                     channel = IpcAdapter::Get()->Accept();
                     LOG_F(INFO,
                           "Node %d is trying to accept connection from node %d "
@@ -240,7 +345,7 @@ void Communicator::ReConnectLinks(const std::tuple<int, int>& num_conn_accept) {
                           "Node %d is trying to accept connection from node %d "
                           "with other "
                           "adapter",
-                          hrank);
+                          GetRank(), hrank);
                 }
 #else
                 channel = GetAdapter()->Accept();
@@ -257,8 +362,52 @@ void Communicator::ReConnectLinks(const std::tuple<int, int>& num_conn_accept) {
                 channel->SendInt(GetRank());
                 CHECK_F(channel->RecvInt(hrank) == WorkStatus::kFinished,
                         "ReConnect Link failure");
-                all_links_[hrank] = schannel;
-                LOG_F(INFO, "%d %d", GetRank(), hrank);
+                if (!over_tcp || num_stripes == 1) {
+                    if (framed && over_tcp) {
+                        schannel = std::make_shared<FramedChannel>(schannel,
+                                                                   eager_limit);
+                    }
+                    all_links_[hrank] = schannel;
+                    LOG_F(INFO, "%d %d", GetRank(), hrank);
+                    return;
+                }
+                // as many connections as stripes, but peers connecting at
+                // the same time interleave, so group them by rank
+                for (int32_t s = 0; s < num_stripes; s++) {
+                    if (s != 0) {
+                        schannel.reset(GetAdapter()->Accept());
+                        schannel->set_comm(name_);
+                        schannel->SendInt(GetRank());
+                        CHECK_F(
+                            schannel->RecvInt(hrank) == WorkStatus::kFinished,
+                            "ReConnect Link failure");
+                    }
+                    int32_t stripe = 0;
+                    CHECK_F(schannel->RecvInt(stripe) == WorkStatus::kFinished,
+                            "ReConnect Link failure");
+                    CHECK_F(stripe >= 0 && stripe < num_stripes,
+                            "node %d sent stripe %d of %d", hrank, stripe,
+                            num_stripes);
+                    schannel->set_peer_rank(hrank);
+                    std::lock_guard<std::mutex> lg(stripes_lock);
+                    auto& stripes = accepted_stripes[hrank];
+                    stripes.resize(num_stripes);
+                    stripes[stripe] = schannel;
+                    if (std::count(stripes.begin(), stripes.end(), nullptr) ==
+                        0) {
+                        std::shared_ptr<IChannel> link =
+                            std::make_shared<StripedChannel>(
+                                stripes, stripe_threshold);
+                        link->set_comm(name_);
+                        link->set_peer_rank(hrank);
+                        if (framed) {
+                            link = std::make_shared<FramedChannel>(
+                                link, eager_limit);
+                        }
+                        all_links_[hrank] = link;
+                        LOG_F(INFO, "%d %d", GetRank(), hrank);
+                    }
+                }
             });
             pool.WaitAll();
         }
@@ -303,11 +452,13 @@ void Communicator::ReConnectLinks(const std::tuple<int, int>& num_conn_accept) {
 void Communicator::Send(Buffer sendbuf, int dest) {
     auto wc = all_links_[dest]->ISend(sendbuf);
     wc->Wait();
+    WorkCompletion::Delete(wc);
     return;
 }
 void Communicator::Recv(Buffer recvbuf, int src) {
     auto wc = all_links_[src]->IRecv(recvbuf);
     wc->Wait();
+    WorkCompletion::Delete(wc);
     return;
 }
 
@@ -319,5 +470,13 @@ WorkCompletion* Communicator::IRecv(Buffer recvbuf, int src) {
     return all_links_[src]->IRecv(recvbuf);
 }
 
+WorkCompletion* Communicator::ISend(Buffer sendbuf, int dest, int tag) {
+    return all_links_[dest]->ISend(sendbuf, tag);
+}
+
+WorkCompletion* Communicator::IRecv(Buffer recvbuf, int src, int tag) {
+    return all_links_[src]->IRecv(recvbuf, tag);
+}
+
 }  // namespace comm
 }  // namespace rdc
@@ -1,14 +1,223 @@
+#include <deque>
 #include "comm/communicator_base.h"
 #include "comm/communicator_manager.h"
+#include "core/exception.h"
+#include "core/reduce_kernels.h"
+#include "utils/timer.h"
+#include "utils/topo_utils.h"
+#ifdef RDC_USE_SHMEM
+#include "transport/ipc/ipc_adapter.h"
+#endif
 
 namespace rdc {
 namespace comm {
 void Communicator::TryAllreduce(Buffer sendrecvbuf, ReduceFunction reducer) {
-    if (sendrecvbuf.size_in_bytes() >
-        CommunicatorManager::Get()->reduce_ring_mincount()) {
-        return this->TryAllreduceRing(sendrecvbuf, reducer);
-    } else {
+    reducer = CommunicatorManager::Get()->parallel_reducer()->Wrap(reducer);
+#ifdef RDC_USE_SHMEM
+    if (auto shm_collective = GetShmCollective()) {
+        return shm_collective->Allreduce(sendrecvbuf, reducer);
+    }
+#endif
+    auto algo = CommunicatorManager::Get()->allreduce_algo();
+    if (algo == AllreduceAlgo::kAuto) {
+        algo = CommunicatorManager::Get()->tuner().Select(
+            sendrecvbuf.size_in_bytes());
+    }
+    switch (algo) {
+        case AllreduceAlgo::kRing:
+            return this->TryAllreduceRing(sendrecvbuf, reducer);
+        case AllreduceAlgo::kTree:
+            return this->TryAllreduceTree(sendrecvbuf, reducer);
+        case AllreduceAlgo::kDoubleTree:
+            return this->TryAllreduceDoubleTree(sendrecvbuf, reducer);
+        case AllreduceAlgo::kHalvingDoubling:
+            return this->TryAllreduceHalvingDoubling(sendrecvbuf, reducer);
+        case AllreduceAlgo::kHierarchical:
+            return this->TryAllreduceHierarchical(sendrecvbuf, reducer);
+        default:
+            break;
+    }
+    const auto& size = sendrecvbuf.size_in_bytes();
+    if (size <= CommunicatorManager::Get()->reduce_ring_mincount()) {
         return this->TryAllreduceTree(sendrecvbuf, reducer);
+    } else if (size <= CommunicatorManager::Get()->reduce_rhd_maxcount()) {
+        return this->TryAllreduceHalvingDoubling(sendrecvbuf, reducer);
+    } else {
+        return this->TryAllreduceRing(sendrecvbuf, reducer);
+    }
+}
+void Communicator::Enqueue(const std::function<void()>& task) {
+    std::unique_lock<std::mutex> progress_lock(progress_lock_);
+    if (progress_pool_ == nullptr) {
+        progress_pool_.reset(new ThreadPool(1));
+    }
+    auto* progress_pool = progress_pool_.get();
+    progress_lock.unlock();
+    progress_pool->AddTask(task);
+}
+void Communicator::TryAllreduceBFloat16(Buffer sendrecvbuf,
+                                        const mpi::OpType& op) {
+    const auto& count = sendrecvbuf.size_in_bytes() / sizeof(float);
+    if (wire_scratch_size_ < count * sizeof(BFloat16)) {
+        utils::Free(wire_scratch_);
+        wire_scratch_ = utils::AllocTemp(count * sizeof(BFloat16));
+        wire_scratch_size_ = count * sizeof(BFloat16);
+    }
+    Buffer wirebuf(wire_scratch_, count * sizeof(BFloat16));
+    wirebuf.set_item_size(sizeof(BFloat16));
+    op::FloatToBFloat16(sendrecvbuf.As<float>(), wirebuf.As<BFloat16>(),
+                        count);
+    auto kernel = op::GetReduceKernel(op, mpi::kBFloat16);
+    CHECK_F(kernel != nullptr, "no bfloat16 reduce kernel for op %d",
+            static_cast<int>(op));
+    TryAllreduce(wirebuf, [kernel](Buffer src, Buffer dst) {
+        kernel(src.addr(), dst.addr(), src.Count());
+    });
+    op::BFloat16ToFloat(wirebuf.As<BFloat16>(), sendrecvbuf.As<float>(),
+                        count);
+}
+Buffer Communicator::GetReduceBuffer(const uint64_t& size_in_bytes,
+                                     const uint64_t& item_size) {
+    if (reduce_scratch_size_ < size_in_bytes) {
+        utils::Free(reduce_scratch_);
+        reduce_scratch_ = utils::AllocTemp(size_in_bytes);
+        reduce_scratch_size_ = size_in_bytes;
+    }
+    Buffer reducebuf(reduce_scratch_, size_in_bytes);
+    if (item_size != 0) {
+        reducebuf.set_item_size(item_size);
+    }
+    return reducebuf;
+}
+WorkCompletion* Communicator::EnqueueCollective(
+    void* ptr, const size_t& size_in_bytes,
+    const std::function<void()>& collective) {
+    auto req_id = WorkRequestManager::Get()->NewWorkRequest(
+        WorkType::kCollective, ptr, size_in_bytes);
+    Enqueue([this, req_id, collective] {
+        auto& work_req = WorkRequestManager::Get()->GetWorkRequest(req_id);
+        work_req.set_status(WorkStatus::kRunning);
+        try {
+            if (GetWorldSize() != 1 && GetWorldSize() != -1) {
+                collective();
+            }
+            work_req.set_status(WorkStatus::kFinished);
+        } catch (const Exception& exc) {
+            PrintException(exc);
+            work_req.set_status(WorkStatus::kError);
+        }
+        work_req.Notify();
+    });
+    return WorkCompletion::New(req_id);
+}
+WorkCompletion* Communicator::IAllreduce(Buffer sendrecvbuf,
+                                         ReduceFunction reducer) {
+    return EnqueueCollective(
+        sendrecvbuf.addr(), sendrecvbuf.size_in_bytes(),
+        [this, sendrecvbuf, reducer] { TryAllreduce(sendrecvbuf, reducer); });
+}
+WorkCompletion* Communicator::IAllreduceBFloat16(Buffer sendrecvbuf,
+                                                 const mpi::OpType& op) {
+    // narrowed on the progress thread, so queued ones share the scratch space
+    return EnqueueCollective(
+        sendrecvbuf.addr(), sendrecvbuf.size_in_bytes(),
+        [this, sendrecvbuf, op] { TryAllreduceBFloat16(sendrecvbuf, op); });
+}
+WorkCompletion* Communicator::IBroadcast(Buffer sendrecvbuf, int root) {
+    return EnqueueCollective(
+        sendrecvbuf.addr(), sendrecvbuf.size_in_bytes(),
+        [this, sendrecvbuf, root] { TryBroadcast(sendrecvbuf, root); });
+}
+WorkCompletion* Communicator::IAllgather(std::vector<Buffer> sendrecvbufs) {
+    size_t size_in_bytes = 0;
+    for (const auto& sendrecvbuf : sendrecvbufs) {
+        size_in_bytes += sendrecvbuf.size_in_bytes();
+    }
+    return EnqueueCollective(nullptr, size_in_bytes, [this, sendrecvbufs] {
+        TryAllgatherRing(sendrecvbufs, GlobalRing());
+    });
+}
+void Communicator::TuneAllreduce(CollectiveTuner* tuner,
+                                 const uint64_t& max_size_in_bytes,
+                                 const int& num_iters) {
+    using AllreduceMethod = void (Communicator::*)(Buffer, ReduceFunction);
+    const std::vector<std::pair<AllreduceAlgo, AllreduceMethod>> candidates = {
+        {AllreduceAlgo::kRing, &Communicator::TryAllreduceRing},
+        {AllreduceAlgo::kTree, &Communicator::TryAllreduceTree},
+        {AllreduceAlgo::kDoubleTree, &Communicator::TryAllreduceDoubleTree},
+        {AllreduceAlgo::kHalvingDoubling,
+         &Communicator::TryAllreduceHalvingDoubling},
+        {AllreduceAlgo::kHierarchical,
+         &Communicator::TryAllreduceHierarchical}};
+    auto sum = [](Buffer src, Buffer dst) {
+        const auto& count = dst.size_in_bytes() / sizeof(float);
+        for (auto i = 0U; i < count; i++) {
+            dst.As<float>()[i] += src.As<float>()[i];
+        }
+    };
+    auto max = [](Buffer src, Buffer dst) {
+        *dst.As<double>() = std::max(*dst.As<double>(), *src.As<double>());
+    };
+    tuner->Clear();
+    if (GetWorldSize() <= 1) {
+        return;
+    }
+    std::vector<float> data(
+        std::max<uint64_t>(max_size_in_bytes, 1 << 10) / sizeof(float), 1.f);
+    for (uint64_t size = 1 << 10;; size <<= 2) {
+        size = std::min<uint64_t>(size, data.size() * sizeof(float));
+        Buffer sendrecvbuf(data.data(), size);
+        sendrecvbuf.set_item_size(sizeof(float));
+        AllreduceAlgo best_algo = AllreduceAlgo::kAuto;
+        double best_time = 0;
+        for (const auto& candidate : candidates) {
+            // warm up once, then take the slowest node as the cost
+            (this->*candidate.second)(sendrecvbuf, sum);
+            double start = utils::GetTime();
+            for (int i = 0; i < num_iters; i++) {
+                (this->*candidate.second)(sendrecvbuf, sum);
+            }
+            double elapsed = utils::GetTime() - start;
+            Buffer elapsed_buf(&elapsed, sizeof(elapsed));
+            elapsed_buf.set_item_size(sizeof(elapsed));
+            this->TryAllreduceTree(elapsed_buf, max);
+            if (best_algo == AllreduceAlgo::kAuto || elapsed < best_time) {
+                best_algo = candidate.first;
+                best_time = elapsed;
+            }
+        }
+        LOG_F(INFO, "[%d] tuned allreduce of %lu bytes: %s", GetRank(), size,
+              AllreduceAlgoName(best_algo).c_str());
+        if (size == data.size() * sizeof(float)) {
+            // the largest bucket also covers every larger message
+            tuner->Add(UINT64_MAX, best_algo);
+            break;
+        }
+        tuner->Add(size, best_algo);
+    }
+}
+void Communicator::ShareTuning(CollectiveTuner* tuner) {
+    if (GetWorldSize() <= 1) {
+        return;
+    }
+    uint64_t num_buckets = tuner->buckets().size();
+    this->TryBroadcast(Buffer(&num_buckets, sizeof(num_buckets)), 0);
+    std::vector<uint64_t> bounds(num_buckets), algos(num_buckets);
+    if (GetRank() == 0) {
+        for (auto i = 0U; i < num_buckets; i++) {
+            bounds[i] = tuner->buckets()[i].first;
+            algos[i] = static_cast<uint64_t>(tuner->buckets()[i].second);
+        }
+    }
+    if (num_buckets != 0) {
+        this->TryBroadcast(Buffer(bounds.data(), num_buckets * sizeof(uint64_t)),
+                           0);
+        this->TryBroadcast(Buffer(algos.data(), num_buckets * sizeof(uint64_t)),
+                           0);
+    }
+    tuner->Clear();
+    for (auto i = 0U; i < num_buckets; i++) {
+        tuner->Add(bounds[i], static_cast<AllreduceAlgo>(algos[i]));
     }
 }
 void Communicator::TryReduceTree(Buffer sendrecvbuf, Buffer reducebuf,
@@ -25,11 +234,25 @@ void Communicator::TryReduceTree(Buffer sendrecvbuf, Buffer reducebuf,
             send_to_node = neighbor;
         }
     }
+    // receive from all children at once, child i into the i-th copy, and
+    // reduce whichever arrives first
+    const auto& size_in_bytes = sendrecvbuf.size_in_bytes();
+    std::vector<WorkCompletion*> recv_wcs;
+    std::vector<Buffer> recvbufs;
     for (const auto& recv_from_node : recv_from_nodes) {
-        auto wc = all_links_[recv_from_node]->IRecv(reducebuf);
-        wc->Wait();
-        reducer(reducebuf, sendrecvbuf);
-        WorkCompletion::Delete(wc);
+        const auto& start = recvbufs.size() * size_in_bytes;
+        recvbufs.emplace_back(reducebuf.Slice(start, start + size_in_bytes));
+        recv_wcs.emplace_back(
+            all_links_[recv_from_node]->IRecv(recvbufs.back()));
+    }
+    while (!recv_wcs.empty()) {
+        const auto& i = WorkCompletion::WaitAny(recv_wcs);
+        CHECK_F(recv_wcs[i]->status() == WorkStatus::kFinished,
+                "[%d] tree reduce failure", GetRank());
+        reducer(recvbufs[i], sendrecvbuf);
+        WorkCompletion::Delete(recv_wcs[i]);
+        recv_wcs.erase(recv_wcs.begin() + i);
+        recvbufs.erase(recvbufs.begin() + i);
     }
 
     auto chain_wc = ChainWorkCompletion::New();
@@ -42,6 +265,11 @@ void Communicator::TryReduceTree(Buffer sendrecvbuf, Buffer reducebuf,
     return;
 }
 void Communicator::TryBroadcast(Buffer sendrecvbuf, int root) {
+#ifdef RDC_USE_SHMEM
+    if (auto shm_collective = GetShmCollective()) {
+        return shm_collective->Broadcast(sendrecvbuf, root);
+    }
+#endif
     auto dists_from_root = tree_map_.ShortestDist(root);
     auto dist_from_root = dists_from_root[GetRank()];
     auto neighbors = tree_map_.GetNeighbors(GetRank());
@@ -55,35 +283,360 @@ void Communicator::TryBroadcast(Buffer sendrecvbuf, int root) {
         }
     }
     auto chain_wc = ChainWorkCompletion::New();
-    if (recv_from_node != -1) {
-        auto wc = all_links_[recv_from_node]->IRecv(sendrecvbuf);
-        chain_wc->Add(wc);
-    }
-    for (const auto& send_to_node : send_to_nodes) {
-        auto wc = all_links_[send_to_node]->ISend(sendrecvbuf);
-        chain_wc->Add(wc);
+    if (recv_from_node == -1) {
+        for (const auto& send_to_node : send_to_nodes) {
+            chain_wc->Add(all_links_[send_to_node]->ISend(sendrecvbuf));
+        }
+    } else {
+        // forward to children right when the data arrives, from the thread
+        // completing the receive
+        auto recv_wc = all_links_[recv_from_node]->IRecv(sendrecvbuf);
+        for (const auto& send_to_node : send_to_nodes) {
+            IChannel* link = all_links_[send_to_node].get();
+            chain_wc->Add(recv_wc->Then(
+                [link, sendrecvbuf] { return link->ISend(sendrecvbuf); }));
+        }
+        chain_wc->Add(recv_wc);
     }
     chain_wc->Wait();
+    CHECK_F(chain_wc->status() == WorkStatus::kFinished,
+            "[%d] broadcast failure", GetRank());
     ChainWorkCompletion::Delete(chain_wc);
     return;
 }
 
 void Communicator::TryAllreduceTree(Buffer sendrecvbuf,
                                     ReduceFunction reducer) {
-    Buffer reducebuf(sendrecvbuf.size_in_bytes());
-    reducebuf.AllocTemp(utils::AllocTemp);
+    // one copy per child, the parent is counted too which is never less
+    const size_t num_neighbors =
+        std::max<size_t>(tree_map_.GetNeighbors(GetRank()).size(), 1);
+    auto reducebuf = GetReduceBuffer(
+        sendrecvbuf.size_in_bytes() * num_neighbors,
+        sendrecvbuf.with_type() ? sendrecvbuf.item_size() : 0);
     TryReduceTree(sendrecvbuf, reducebuf, reducer, 0);
-    reducebuf.FreeTemp(utils::Free);
     TryBroadcast(sendrecvbuf, 0);
 }
-void Communicator::TryAllgatherRing(std::vector<Buffer> sendrecvbufs) {
+void Communicator::TryAllreduceDoubleTree(Buffer sendrecvbuf,
+                                          ReduceFunction reducer) {
+    const auto& item_size = sendrecvbuf.item_size();
+    const auto& size_in_bytes = sendrecvbuf.size_in_bytes();
+    const auto& trees = GetDoubleTree(GetRank(), GetWorldSize());
+    const auto& halves = utils::Split(0, sendrecvbuf.Count(), 2);
+    std::vector<Buffer> parts(2);
+    std::vector<int> parents(2);
+    std::vector<std::vector<int>> children(2);
+    for (auto t = 0U; t < 2; t++) {
+        parts[t] = sendrecvbuf.Slice(halves[t].first * item_size,
+                                     halves[t].second * item_size);
+        std::tie(parents[t], children[t]) = trees[t];
+    }
+    // a node has at most two children in each tree, child j of a tree
+    // receives into the j-th copy of the corresponding half
+    auto reducebuf = GetReduceBuffer(size_in_bytes * 2, item_size);
+    // post receives of both trees up front, so that the second half flows in
+    // while the first one is being reduced, empty halves are skipped on both
+    // sides of every link
+    std::vector<std::vector<WorkCompletion*>> reduce_wcs(2);
+    for (auto t = 0U; t < 2; t++) {
+        if (parts[t].size_in_bytes() == 0) continue;
+        for (auto j = 0U; j < children[t].size(); j++) {
+            uint64_t start = j * size_in_bytes + halves[t].first * item_size;
+            uint64_t end = j * size_in_bytes + halves[t].second * item_size;
+            reduce_wcs[t].emplace_back(all_links_[children[t][j]]->IRecv(
+                reducebuf.Slice(start, end)));
+        }
+    }
+    auto chain_wc = ChainWorkCompletion::New();
+    for (auto t = 0U; t < 2; t++) {
+        if (parts[t].size_in_bytes() == 0) continue;
+        for (auto j = 0U; j < reduce_wcs[t].size(); j++) {
+            auto wc = reduce_wcs[t][j];
+            wc->Wait();
+            CHECK_F(wc->status() == WorkStatus::kFinished,
+                    "[%d] double tree reduce failure", GetRank());
+            WorkCompletion::Delete(wc);
+            uint64_t start = j * size_in_bytes + halves[t].first * item_size;
+            uint64_t end = j * size_in_bytes + halves[t].second * item_size;
+            reducer(reducebuf.Slice(start, end), parts[t]);
+        }
+        if (parents[t] != -1) {
+            chain_wc->Add(all_links_[parents[t]]->ISend(parts[t]));
+        }
+    }
+    chain_wc->Wait();
+    ChainWorkCompletion::Delete(chain_wc);
+    // broadcast reduced halves back down their trees, each half is forwarded
+    // as soon as it arrives, regardless of the other one
+    chain_wc = ChainWorkCompletion::New();
+    for (auto t = 0U; t < 2; t++) {
+        if (parts[t].size_in_bytes() == 0) continue;
+        if (parents[t] == -1) {
+            for (const auto& child : children[t]) {
+                chain_wc->Add(all_links_[child]->ISend(parts[t]));
+            }
+            continue;
+        }
+        auto recv_wc = all_links_[parents[t]]->IRecv(parts[t]);
+        for (const auto& child : children[t]) {
+            IChannel* link = all_links_[child].get();
+            const auto& part = parts[t];
+            chain_wc->Add(
+                recv_wc->Then([link, part] { return link->ISend(part); }));
+        }
+        chain_wc->Add(recv_wc);
+    }
+    chain_wc->Wait();
+    CHECK_F(chain_wc->status() == WorkStatus::kFinished,
+            "[%d] double tree broadcast failure", GetRank());
+    ChainWorkCompletion::Delete(chain_wc);
+}
+void Communicator::TryAllreduceHalvingDoubling(Buffer sendrecvbuf,
+                                               ReduceFunction reducer) {
+    const int rank = GetRank();
+    const int n = GetWorldSize();
+    const auto& item_size = sendrecvbuf.item_size();
+    // largest power of two not greater than world size
+    int pof2 = 1;
+    while (pof2 * 2 <= n) {
+        pof2 <<= 1;
+    }
+    const int rem = n - pof2;
+    auto reducebuf = GetReduceBuffer(sendrecvbuf.size_in_bytes(), item_size);
+    // pre fold: among the first 2 * rem nodes, even ones hand their data to
+    // the following odd one and sit out the power of two exchange
+    int new_rank = -1;
+    if (rank < 2 * rem) {
+        if (rank % 2 == 0) {
+            auto wc = all_links_[rank + 1]->ISend(sendrecvbuf);
+            wc->Wait();
+            WorkCompletion::Delete(wc);
+        } else {
+            auto wc = all_links_[rank - 1]->IRecv(reducebuf);
+            wc->Wait();
+            CHECK_F(wc->status() == WorkStatus::kFinished,
+                    "[%d] halving doubling fold failure", rank);
+            WorkCompletion::Delete(wc);
+            reducer(reducebuf, sendrecvbuf);
+            new_rank = rank / 2;
+        }
+    } else {
+        new_rank = rank - rem;
+    }
+    if (new_rank != -1) {
+        auto real_rank = [rem](int r) { return r < rem ? r * 2 + 1 : r + rem; };
+        // exchange the give range with peer and receive the keep range,
+        // both ranges are in items, empty ranges are empty on both sides
+        auto exchange = [&](int peer, uint64_t send_begin, uint64_t send_end,
+                            Buffer recvbuf, uint64_t recv_begin,
+                            uint64_t recv_end) {
+            auto chain_wc = ChainWorkCompletion::New();
+            if (send_end > send_begin) {
+                chain_wc->Add(all_links_[peer]->ISend(sendrecvbuf.Slice(
+                    send_begin * item_size, send_end * item_size)));
+            }
+            if (recv_end > recv_begin) {
+                chain_wc->Add(all_links_[peer]->IRecv(recvbuf.Slice(
+                    recv_begin * item_size, recv_end * item_size)));
+            }
+            chain_wc->Wait();
+            CHECK_F(chain_wc->status() == WorkStatus::kFinished,
+                    "[%d] halving doubling exchange failure with %d", rank,
+                    peer);
+            ChainWorkCompletion::Delete(chain_wc);
+        };
+        // reduce-scatter by recursive halving, the node with the lower rank
+        // keeps the lower half of the current range
+        uint64_t begin = 0, end = sendrecvbuf.Count();
+        std::vector<std::tuple<int, bool, uint64_t, uint64_t, uint64_t>> steps;
+        for (int mask = pof2 >> 1; mask > 0; mask >>= 1) {
+            int peer = real_rank(new_rank ^ mask);
+            uint64_t mid = begin + (end - begin) / 2;
+            uint64_t keep_begin = begin, keep_end = mid;
+            uint64_t give_begin = mid, give_end = end;
+            const bool keep_lower = (new_rank & mask) == 0;
+            if (!keep_lower) {
+                std::swap(keep_begin, give_begin);
+                std::swap(keep_end, give_end);
+            }
+            exchange(peer, give_begin, give_end, reducebuf, keep_begin,
+                     keep_end);
+            if (keep_end > keep_begin) {
+                reducer(reducebuf.Slice(keep_begin * item_size,
+                                        keep_end * item_size),
+                        sendrecvbuf.Slice(keep_begin * item_size,
+                                          keep_end * item_size));
+            }
+            steps.emplace_back(peer, keep_lower, begin, mid, end);
+            begin = keep_begin;
+            end = keep_end;
+        }
+        // allgather by recursive doubling, replay the steps backwards and
+        // exchange the reduced range for the one given away
+        for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+            int peer;
+            bool keep_lower;
+            uint64_t step_begin, step_mid, step_end;
+            std::tie(peer, keep_lower, step_begin, step_mid, step_end) = *it;
+            if (keep_lower) {
+                exchange(peer, step_begin, step_mid, sendrecvbuf, step_mid,
+                         step_end);
+            } else {
+                exchange(peer, step_mid, step_end, sendrecvbuf, step_begin,
+                         step_mid);
+            }
+        }
+    }
+    // post fold: odd nodes hand the result back to their even partner
+    if (rank < 2 * rem) {
+        WorkCompletion* wc = nullptr;
+        if (rank % 2 == 0) {
+            wc = all_links_[rank + 1]->IRecv(sendrecvbuf);
+        } else {
+            wc = all_links_[rank - 1]->ISend(sendrecvbuf);
+        }
+        wc->Wait();
+        CHECK_F(wc->status() == WorkStatus::kFinished,
+                "[%d] halving doubling unfold failure", rank);
+        WorkCompletion::Delete(wc);
+    }
+}
+const std::vector<int>& Communicator::GetHostLeaders() {
+    if (!host_leaders_.empty()) {
+        return host_leaders_;
+    }
+    auto&& local_peers = Tracker::Get()->peers_with_same_host();
+    const int n = GetWorldSize();
+    std::vector<int> leader_of(n);
+    leader_of[GetRank()] =
+        local_peers.empty() ? GetRank() : local_peers.front();
+    std::vector<Buffer> sendrecvbufs(n);
+    for (int i = 0; i < n; i++) {
+        sendrecvbufs[i].set_size_in_bytes(sizeof(int));
+        sendrecvbufs[i].set_addr(&leader_of[i]);
+    }
+    TryAllgatherRing(sendrecvbufs, GlobalRing());
+    for (int i = 0; i < n; i++) {
+        if (leader_of[i] == i) {
+            host_leaders_.emplace_back(i);
+        }
+    }
+    return host_leaders_;
+}
+#ifdef RDC_USE_SHMEM
+ShmCollective* Communicator::GetShmCollective() {
+    if (shm_collective_probed_) {
+        return shm_collective_.get();
+    }
+    // set first, the agreement below runs a broadcast over the links
+    shm_collective_probed_ = true;
+    const auto& slot_size = IpcAdapter::Get()->coll_slot_size();
+    auto&& local_peers = Tracker::Get()->peers_with_same_host();
+    if (slot_size == 0 || GetWorldSize() <= 1 ||
+        local_peers.size() != static_cast<size_t>(GetWorldSize())) {
+        return nullptr;
+    }
+    // the host holds the whole communicator, so arena ranks are our ranks
+    std::unique_ptr<ShmCollective> shm_collective(
+        new ShmCollective(IpcAdapter::Get()->ArenaName(name_), GetRank(),
+                          GetWorldSize(), slot_size));
+    int32_t attached = shm_collective->Attach() ? 1 : 0;
+    // every node has to take the same path
+    auto min = [](Buffer src, Buffer dst) {
+        *dst.As<int32_t>() = std::min(*dst.As<int32_t>(), *src.As<int32_t>());
+    };
+    Buffer attached_buf(&attached, sizeof(attached));
+    attached_buf.set_item_size(sizeof(attached));
+    this->TryAllreduceTree(attached_buf, min);
+    if (attached) {
+        shm_collective_ = std::move(shm_collective);
+    } else {
+        LOG_F(WARNING, "[%d] shared memory collectives of %s are disabled",
+              GetRank(), name_.c_str());
+    }
+    return shm_collective_.get();
+}
+#endif
+void Communicator::TryAllreduceHierarchical(Buffer sendrecvbuf,
+                                            ReduceFunction reducer) {
+    const auto& leaders = GetHostLeaders();
+    // one node per host, nothing to gain over the flat ring
+    if (leaders.size() == static_cast<size_t>(GetWorldSize())) {
+        return this->TryAllreduceRing(sendrecvbuf, reducer);
+    }
+    auto&& local_peers = Tracker::Get()->peers_with_same_host();
+    const int rank = GetRank();
+    const int leader = local_peers.empty() ? rank : local_peers.front();
+    if (rank != leader) {
+        auto wc = all_links_[leader]->ISend(sendrecvbuf);
+        wc->Wait();
+        WorkCompletion::Delete(wc);
+        wc = all_links_[leader]->IRecv(sendrecvbuf);
+        wc->Wait();
+        CHECK_F(wc->status() == WorkStatus::kFinished,
+                "[%d] hierarchical broadcast failure from %d", rank, leader);
+        WorkCompletion::Delete(wc);
+        return;
+    }
+    std::vector<int> locals;
+    for (const auto& peer : local_peers) {
+        if (peer != rank) {
+            locals.emplace_back(peer);
+        }
+    }
+    // intra-host reduce, two receive slots so the next peer's data flows in
+    // while the previous one is being reduced
+    const auto& size_in_bytes = sendrecvbuf.size_in_bytes();
+    auto reducebuf =
+        GetReduceBuffer(size_in_bytes * 2, sendrecvbuf.item_size());
+    auto slot = [&](size_t i) {
+        return reducebuf.Slice((i % 2) * size_in_bytes,
+                               (i % 2 + 1) * size_in_bytes);
+    };
+    std::deque<WorkCompletion*> inflight_recvs;
+    for (size_t i = 0; i < locals.size() && i < 2; i++) {
+        inflight_recvs.emplace_back(all_links_[locals[i]]->IRecv(slot(i)));
+    }
+    for (size_t i = 0; i < locals.size(); i++) {
+        auto wc = inflight_recvs.front();
+        inflight_recvs.pop_front();
+        wc->Wait();
+        CHECK_F(wc->status() == WorkStatus::kFinished,
+                "[%d] hierarchical reduce failure from %d", rank, locals[i]);
+        WorkCompletion::Delete(wc);
+        reducer(slot(i), sendrecvbuf);
+        if (i + 2 < locals.size()) {
+            inflight_recvs.emplace_back(
+                all_links_[locals[i + 2]]->IRecv(slot(i)));
+        }
+    }
+    // inter-host ring among leaders
+    if (leaders.size() > 1) {
+        const int num_leaders = static_cast<int>(leaders.size());
+        const int pos = static_cast<int>(
+            std::find(leaders.begin(), leaders.end(), rank) - leaders.begin());
+        RingView ring{
+            all_links_[leaders[(pos + num_leaders - 1) % num_leaders]].get(),
+            all_links_[leaders[(pos + 1) % num_leaders]].get(), pos,
+            num_leaders};
+        this->TryAllreduceRing(sendrecvbuf, reducer, ring);
+    }
+    // intra-host broadcast
+    auto chain_wc = ChainWorkCompletion::New();
+    for (const auto& peer : locals) {
+        chain_wc->Add(all_links_[peer]->ISend(sendrecvbuf));
+    }
+    chain_wc->Wait();
+    ChainWorkCompletion::Delete(chain_wc);
+}
+void Communicator::TryAllgatherRing(std::vector<Buffer> sendrecvbufs,
+                                    const RingView& ring) {
     // read from next link and send to prev one
-    auto &prev = ring_prev_, &next = ring_next_;
-    const size_t count_bufs = GetWorldSize();
-    const size_t stop_write_idx = count_bufs + GetRank() - 1;
-    const size_t stop_read_idx = count_bufs + GetRank();
-    size_t write_idx = GetRank();
-    size_t read_idx = GetRank() + 1;
+    auto &prev = ring.prev, &next = ring.next;
+    const size_t count_bufs = ring.size;
+    const size_t stop_write_idx = count_bufs + ring.rank - 1;
+    const size_t stop_read_idx = count_bufs + ring.rank;
+    size_t write_idx = ring.rank;
+    size_t read_idx = ring.rank + 1;
     while (true) {
         bool finished = true;
         if (read_idx != stop_read_idx) {
@@ -113,18 +666,20 @@ void Communicator::TryAllgatherRing(std::vector<Buffer> sendrecvbufs) {
     }
 }
 void Communicator::TryReduceScatterRing(Buffer sendrecvbuf, Buffer reducebuf,
-                                        ReduceFunction reducer) {
+                                        ReduceFunction reducer,
+                                        const RingView& ring) {
     // read from next link and send to prev one
-    auto &&prev = ring_prev_, &&next = ring_next_;
-    uint64_t n = static_cast<uint64_t>(GetWorldSize());
+    auto &&prev = ring.prev, &&next = ring.next;
+    uint64_t n = static_cast<uint64_t>(ring.size);
     const auto& ranges = utils::Split(0, sendrecvbuf.Count(), n);
-    uint64_t write_idx = GetNextRank();
-    uint64_t read_idx = GetNextRank() + 1;
+    const uint64_t next_rank = (ring.rank + 1) % n;
+    uint64_t write_idx = next_rank;
+    uint64_t read_idx = next_rank + 1;
     uint64_t reduce_idx = read_idx;
     // position to stop reading
-    const uint64_t stop_read_idx = n + GetNextRank();
+    const uint64_t stop_read_idx = n + next_rank;
     // position to stop writing
-    size_t stop_write_idx = n + GetRank();
+    size_t stop_write_idx = n + ring.rank;
     ;
     const auto& item_size = sendrecvbuf.item_size();
     if (stop_write_idx > stop_read_idx) {
@@ -180,14 +735,96 @@ void Communicator::TryReduceScatterRing(Buffer sendrecvbuf, Buffer reducebuf,
     }
     return;
 }
+void Communicator::TryReduceScatterRingPipelined(Buffer sendrecvbuf,
+                                                 Buffer reducebuf,
+                                                 ReduceFunction reducer,
+                                                 const RingView& ring) {
+    // read from next link and send to prev one
+    auto &&prev = ring.prev, &&next = ring.next;
+    uint64_t n = static_cast<uint64_t>(ring.size);
+    const auto& ranges = utils::Split(0, sendrecvbuf.Count(), n);
+    const uint64_t next_rank = (ring.rank + 1) % n;
+    const auto& item_size = sendrecvbuf.item_size();
+    const uint64_t chunk_count = std::max<uint64_t>(
+        1, CommunicatorManager::Get()->ring_chunk_size() / item_size);
+    const uint64_t depth = std::max<uint64_t>(
+        1, CommunicatorManager::Get()->ring_pipeline_depth());
+    // split a segment into byte ranges of at most chunk_count items, both
+    // sides of a link derive the same chunks from the same segment
+    auto split_segment = [&](uint64_t pos) {
+        std::vector<std::pair<uint64_t, uint64_t>> chunks;
+        for (uint64_t begin = ranges[pos].first; begin < ranges[pos].second;
+             begin += chunk_count) {
+            uint64_t end = std::min<uint64_t>(begin + chunk_count,
+                                              ranges[pos].second);
+            chunks.emplace_back(begin * item_size, end * item_size);
+        }
+        return chunks;
+    };
+    // at step t we receive segment (next + 1 + t) from next, reduce it, and
+    // forward it to prev at step t + 1, at step 0 we forward our own next
+    // segment, after n - 1 steps segment rank is fully reduced here
+    std::vector<std::pair<uint64_t, uint64_t>> recv_chunks;
+    std::vector<uint64_t> recv_steps;
+    for (uint64_t t = 0; t + 1 < n; t++) {
+        for (const auto& chunk : split_segment((next_rank + 1 + t) % n)) {
+            recv_chunks.emplace_back(chunk);
+            recv_steps.emplace_back(t);
+        }
+    }
+    auto send_chain_wc = ChainWorkCompletion::New();
+    for (const auto& chunk : split_segment(next_rank)) {
+        auto wc =
+            prev->ISend(sendrecvbuf.Slice(chunk.first, chunk.second));
+        send_chain_wc->Add(wc);
+    }
+    std::deque<WorkCompletion*> inflight_recvs;
+    uint64_t posted_idx = 0;
+    for (uint64_t i = 0; i < recv_chunks.size(); i++) {
+        // keep up to depth sub-chunks in flight ahead of the reduction
+        while (posted_idx < recv_chunks.size() && posted_idx < i + depth) {
+            const auto& chunk = recv_chunks[posted_idx];
+            inflight_recvs.emplace_back(
+                next->IRecv(reducebuf.Slice(chunk.first, chunk.second)));
+            posted_idx++;
+        }
+        auto wc = inflight_recvs.front();
+        inflight_recvs.pop_front();
+        wc->Wait();
+        CHECK_F(wc->status() == WorkStatus::kFinished,
+                "[%d] pipelined ring recv failure", GetRank());
+        WorkCompletion::Delete(wc);
+        const auto& chunk = recv_chunks[i];
+        reducer(reducebuf.Slice(chunk.first, chunk.second),
+                sendrecvbuf.Slice(chunk.first, chunk.second));
+        // the last step reduces our own segment which is not forwarded
+        if (recv_steps[i] + 2 < n) {
+            auto send_wc =
+                prev->ISend(sendrecvbuf.Slice(chunk.first, chunk.second));
+            send_chain_wc->Add(send_wc);
+        }
+    }
+    send_chain_wc->Wait();
+    ChainWorkCompletion::Delete(send_chain_wc);
+    return;
+}
 void Communicator::TryAllreduceRing(Buffer sendrecvbuf,
                                     ReduceFunction reducer) {
-    Buffer reducebuf(sendrecvbuf.size_in_bytes());
-    reducebuf.AllocTemp(utils::AllocTemp);
-    reducebuf.set_item_size(sendrecvbuf.item_size());
-    TryReduceScatterRing(sendrecvbuf, reducebuf, reducer);
-    reducebuf.FreeTemp(utils::Free);
-    uint64_t n = static_cast<uint64_t>(GetWorldSize());
+    TryAllreduceRing(sendrecvbuf, reducer, GlobalRing());
+}
+void Communicator::TryAllreduceRing(Buffer sendrecvbuf, ReduceFunction reducer,
+                                    const RingView& ring) {
+    auto reducebuf = GetReduceBuffer(sendrecvbuf.size_in_bytes(),
+                                     sendrecvbuf.item_size());
+    const auto& chunk_size = CommunicatorManager::Get()->ring_chunk_size();
+    // only pipeline when a segment spans more than one sub-chunk
+    if (chunk_size != 0 &&
+        sendrecvbuf.size_in_bytes() > chunk_size * ring.size) {
+        TryReduceScatterRingPipelined(sendrecvbuf, reducebuf, reducer, ring);
+    } else {
+        TryReduceScatterRing(sendrecvbuf, reducebuf, reducer, ring);
+    }
+    uint64_t n = static_cast<uint64_t>(ring.size);
     const auto& ranges = utils::Split(0, sendrecvbuf.Count(), n);
     // get rank of previous
     std::vector<Buffer> sendrecvbufs(n);
@@ -199,7 +836,7 @@ void Communicator::TryAllreduceRing(Buffer sendrecvbuf,
         sendrecvbufs[i].set_addr(utils::IncrVoidPtr(
             sendrecvbuf.addr(), begin * sendrecvbuf.item_size()));
     }
-    return TryAllgatherRing(sendrecvbufs);
+    return TryAllgatherRing(sendrecvbufs, ring);
 }
 }  // namespace comm
 }  // namespace rdc
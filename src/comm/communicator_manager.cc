@@ -2,6 +2,7 @@
 #include "comm/communicator_robust.h"
 #include "comm/tracker.h"
 #include "common/threadpool.h"
+#include "core/reduce_kernels.h"
 #include "transport/tcp/tcp_adapter.h"
 
 namespace rdc {
@@ -41,14 +42,46 @@ inline size_t ParseUnit(const char* name, const char* val) {
     }
 }
 
+// util to parse the name of an allreduce algorithm
+inline AllreduceAlgo ParseAllreduceAlgo(const char* name, const char* val) {
+    AllreduceAlgo algo = AllreduceAlgo::kAuto;
+    if (!AllreduceAlgoFromName(val, &algo)) {
+        LOG_F(ERROR,
+              "invalid value %s for %s, should be one of "
+              "{auto, ring, tree, dtree, rhd, hier}",
+              val, name);
+    }
+    return algo;
+}
+
 CommunicatorManager::CommunicatorManager() {
     // 32 K items
     reduce_ring_mincount_ = 1;
     // reduce_ring_mincount_ = 1 << 15;
+    ring_pipeline_depth_ = 4;
+    allreduce_algo_ = AllreduceAlgo::kAuto;
+    autotune_ = false;
+    autotune_iters_ = 5;
+    allreduce_bf16_wire_ = false;
+    reduce_threads_ =
+        std::min<size_t>(4, std::thread::hardware_concurrency() / 2);
 
     // setup possible enviroment variable of intrest
     env_vars_.push_back("rdc_reduce_buffer");
     env_vars_.push_back("rdc_reduce_ring_mincount");
+    env_vars_.push_back("rdc_reduce_rhd_maxcount");
+    env_vars_.push_back("rdc_allreduce_algo");
+    env_vars_.push_back("rdc_ring_chunk_size");
+    env_vars_.push_back("rdc_ring_pipeline_depth");
+    env_vars_.push_back("rdc_tuning_file");
+    env_vars_.push_back("rdc_autotune");
+    env_vars_.push_back("rdc_autotune_maxsize");
+    env_vars_.push_back("rdc_autotune_iters");
+    env_vars_.push_back("rdc_fusion_threshold");
+    env_vars_.push_back("rdc_fusion_buffer");
+    env_vars_.push_back("rdc_reduce_threads");
+    env_vars_.push_back("rdc_reduce_parallel_minsize");
+    env_vars_.push_back("rdc_allreduce_bf16_wire");
     env_vars_.push_back("RDC_NUM_ATTEMPT");
     env_vars_.push_back("RDC_TRACKER_URI");
     env_vars_.push_back("RDC_TRACKER_PORT");
@@ -56,6 +89,12 @@ CommunicatorManager::CommunicatorManager() {
     env_vars_.push_back("RDC_RESTART");
     env_vars_.push_back("WORKER_CONNECT_RETRY");
     this->SetParam("rdc_reduce_buffer", "256MB");
+    this->SetParam("rdc_ring_chunk_size", "1M");
+    this->SetParam("rdc_reduce_rhd_maxcount", "4M");
+    this->SetParam("rdc_autotune_maxsize", "16M");
+    this->SetParam("rdc_fusion_threshold", "64K");
+    this->SetParam("rdc_fusion_buffer", "16M");
+    this->SetParam("rdc_reduce_parallel_minsize", "1M");
 }
 CommunicatorManager* CommunicatorManager::Get() {
     bool created_ = created.load(std::memory_order_relaxed);
@@ -109,12 +148,28 @@ void CommunicatorManager::Init(int argc, char** argv) {
         str_utils::SPrintf("log/%d", Tracker::Get()->rank()).c_str(),
         logging::Truncate, logging::Verbosity_MAX);
     logging::g_stderr_verbosity = 1;
+    LOG_F(INFO, "Built-in reductions use %s kernels", op::ReduceKernelIsa());
+    // a shipped tuning table takes precedence over measuring one
+    if (!tuning_file_.empty() && tuner_.Load(tuning_file_)) {
+        LOG_F(INFO, "Loaded allreduce tuning table from %s",
+              tuning_file_.c_str());
+    }
+    if (fusion_threshold_ > fusion_buffer_size_) {
+        LOG_F(WARNING, "rdc_fusion_threshold is larger than rdc_fusion_buffer, "
+                       "clamp it to the buffer size");
+        fusion_threshold_ = fusion_buffer_size_;
+    }
+    fusion_buffer_.reset(new FusionBuffer(fusion_buffer_size_));
+    parallel_reducer_.reset(
+        new ParallelReducer(reduce_threads_, reduce_parallel_minsize_));
     deamon_.reset(new Deamon);
 
     checkpointer_.reset(new CheckPointer);
 }
 
 void CommunicatorManager::Finalize() {
+    // requests which are never waited still have to go out on every node
+    fusion_buffer_->FlushAll();
     for (auto&& comm : communicators_) {
         if (comm.second->name() == kMainCommName) {
             comm.second->Shutdown();
@@ -156,6 +211,45 @@ void CommunicatorManager::SetParam(const char* name, const char* val) {
     if (!strcmp(name, "rdc_reduce_ring_mincount")) {
         this->reduce_ring_mincount_ = ParseUnit(name, val);
     }
+    if (!strcmp(name, "rdc_reduce_rhd_maxcount")) {
+        this->reduce_rhd_maxcount_ = ParseUnit(name, val);
+    }
+    if (!strcmp(name, "rdc_allreduce_algo")) {
+        this->allreduce_algo_ = ParseAllreduceAlgo(name, val);
+    }
+    if (!strcmp(name, "rdc_ring_chunk_size")) {
+        this->ring_chunk_size_ = ParseUnit(name, val);
+    }
+    if (!strcmp(name, "rdc_ring_pipeline_depth")) {
+        this->ring_pipeline_depth_ = atoi(val);
+    }
+    if (!strcmp(name, "rdc_tuning_file")) {
+        this->tuning_file_ = val;
+    }
+    if (!strcmp(name, "rdc_autotune")) {
+        this->autotune_ = atoi(val);
+    }
+    if (!strcmp(name, "rdc_autotune_maxsize")) {
+        this->autotune_maxsize_ = ParseUnit(name, val);
+    }
+    if (!strcmp(name, "rdc_autotune_iters")) {
+        this->autotune_iters_ = atoi(val);
+    }
+    if (!strcmp(name, "rdc_fusion_threshold")) {
+        this->fusion_threshold_ = ParseUnit(name, val);
+    }
+    if (!strcmp(name, "rdc_fusion_buffer")) {
+        this->fusion_buffer_size_ = ParseUnit(name, val);
+    }
+    if (!strcmp(name, "rdc_reduce_threads")) {
+        this->reduce_threads_ = atoi(val);
+    }
+    if (!strcmp(name, "rdc_reduce_parallel_minsize")) {
+        this->reduce_parallel_minsize_ = ParseUnit(name, val);
+    }
+    if (!strcmp(name, "rdc_allreduce_bf16_wire")) {
+        this->allreduce_bf16_wire_ = atoi(val);
+    }
     if (!strcmp(name, "RDC_WORKER_CONNECT_RETRY")) {
         this->connect_retry_ = atoi(val);
     }
@@ -180,6 +274,18 @@ std::shared_ptr<ICommunicator> CommunicatorManager::NewCommunicator(
     // connection in current communicator
     comm->Init(Tracker::Get()->world_size(), Tracker::Get()->num_conn(),
                Tracker::Get()->num_accept());
+    // every node has to pick the same algorithm, only the table of node 0
+    // counts, it is loaded before any communicator exists
+    if (comm_names_.size() == 1) {
+        comm->ShareTuning(&tuner_);
+    }
+    // all communicators span the same links, measure once with the first
+    if (autotune_ && tuner_.empty()) {
+        comm->TuneAllreduce(&tuner_, autotune_maxsize_, autotune_iters_);
+        if (!tuning_file_.empty() && Tracker::Get()->rank() == 0) {
+            tuner_.Save(tuning_file_);
+        }
+    }
     //    conn_lock_.unlock();
     // add this communicator to the goverment of main communicator
     comm_lock.lock();
@@ -0,0 +1,115 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file fusion_buffer.cc
+ * \brief implementation of batching of small non-blocking allreduces
+ *
+ * \author Ankun Zheng
+ */
+#include "comm/fusion_buffer.h"
+#include <cstring>
+#include "comm/communicator_manager.h"
+#include "core/logging.h"
+#include "utils/utils.h"
+
+namespace rdc {
+namespace comm {
+FusionBuffer::FusionBuffer(const size_t& capacity) : capacity_(capacity) {
+}
+
+FusionBuffer::~FusionBuffer() {
+    for (auto& staging_buf : free_staging_bufs_) {
+        utils::Free(staging_buf);
+    }
+}
+
+WorkCompletion* FusionBuffer::Add(const std::string& comm_name,
+                                  Buffer sendrecvbuf, ReduceFunction reducer,
+                                  const mpi::DataType& dtype,
+                                  const mpi::OpType& op) {
+    CHECK_F(sendrecvbuf.size_in_bytes() <= capacity_,
+            "allreduce of %lu bytes does not fit in fusion buffer of %lu",
+            sendrecvbuf.size_in_bytes(), capacity_);
+    BatchKey key = std::make_tuple(comm_name, static_cast<int>(dtype),
+                                   static_cast<int>(op));
+    auto req_id = WorkRequestManager::Get()->NewWorkRequest(
+        WorkType::kCollective, sendrecvbuf.addr(),
+        sendrecvbuf.size_in_bytes());
+    // waiting a request which is still queued flushes its batch
+    WorkRequestManager::Get()->GetWorkRequest(req_id).set_wait_callback(
+        [this, key] { this->Flush(key); });
+    std::lock_guard<std::mutex> lg(lock_);
+    auto& batch = batches_[key];
+    if (batch.size_in_bytes + sendrecvbuf.size_in_bytes() > capacity_) {
+        FlushLocked(key);
+    }
+    batch.reducer = reducer;
+    batch.item_size = sendrecvbuf.item_size();
+    batch.size_in_bytes += sendrecvbuf.size_in_bytes();
+    batch.entries.emplace_back(sendrecvbuf, req_id);
+    return WorkCompletion::New(req_id);
+}
+
+void FusionBuffer::Flush(const BatchKey& key) {
+    std::lock_guard<std::mutex> lg(lock_);
+    FlushLocked(key);
+}
+
+void FusionBuffer::FlushAll() {
+    std::lock_guard<std::mutex> lg(lock_);
+    for (const auto& batch : batches_) {
+        FlushLocked(batch.first);
+    }
+}
+
+void FusionBuffer::FlushLocked(const BatchKey& key) {
+    auto& pending = batches_[key];
+    if (pending.entries.empty()) {
+        return;
+    }
+    Batch batch;
+    std::swap(batch, pending);
+    void* staging_buf = nullptr;
+    if (free_staging_bufs_.empty()) {
+        staging_buf = utils::AllocTemp(capacity_);
+    } else {
+        staging_buf = free_staging_bufs_.back();
+        free_staging_bufs_.pop_back();
+    }
+    uint64_t offset = 0;
+    for (auto& entry : batch.entries) {
+        const auto& size_in_bytes = entry.first.size_in_bytes();
+        std::memcpy(utils::IncrVoidPtr(staging_buf, offset),
+                    entry.first.addr(), size_in_bytes);
+        offset += size_in_bytes;
+        WorkRequestManager::Get()
+            ->GetWorkRequest(entry.second)
+            .set_status(WorkStatus::kRunning);
+    }
+    Buffer fusedbuf(staging_buf, batch.size_in_bytes);
+    fusedbuf.set_item_size(batch.item_size);
+    auto comm = CommunicatorManager::Get()->GetCommunicator(std::get<0>(key));
+    auto wc = comm->IAllreduce(fusedbuf, batch.reducer);
+    // runs right after the fused allreduce on the same progress thread
+    comm->Enqueue([this, wc, staging_buf, batch] {
+        auto status = wc->status();
+        WorkCompletion::Delete(wc);
+        uint64_t offset = 0;
+        for (const auto& entry : batch.entries) {
+            const auto& size_in_bytes = entry.first.size_in_bytes();
+            if (status == WorkStatus::kFinished) {
+                std::memcpy(entry.first.addr(),
+                            utils::IncrVoidPtr(staging_buf, offset),
+                            size_in_bytes);
+            }
+            offset += size_in_bytes;
+            auto& work_req =
+                WorkRequestManager::Get()->GetWorkRequest(entry.second);
+            work_req.set_status(status);
+            work_req.Notify();
+        }
+        std::lock_guard<std::mutex> lg(lock_);
+        free_staging_bufs_.emplace_back(staging_buf);
+    });
+}
+}  // namespace comm
+}  // namespace rdc
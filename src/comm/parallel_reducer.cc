@@ -0,0 +1,112 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file parallel_reducer.cc
+ * \brief implementation of multi-threaded reduction of large segments
+ *
+ * \author Ankun Zheng
+ */
+#include "comm/parallel_reducer.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <algorithm>
+#include <thread>
+#include "common/env.h"
+#include "common/semaphore.h"
+#include "core/logging.h"
+
+namespace rdc {
+namespace comm {
+// parts are aligned to cache lines so workers never share one in dst
+static const uint64_t kPartAlign = 64;
+
+ParallelReducer::ParallelReducer(const size_t& num_workers,
+                                 const size_t& min_size)
+    : num_workers_(num_workers), min_size_(min_size) {
+    // processes sharing a host pin their workers to different cores, so
+    // pinning is only done when asked where to
+    first_core_ = Env::Get()->GetEnv("RDC_REDUCE_CORE", -1);
+    if (num_workers_ == 0) {
+        return;
+    }
+    if (first_core_ >= 0) {
+        pool_.reset(new ThreadPool(
+            num_workers_, [this](const size_t& index) { PinWorker(index); }));
+    } else {
+        pool_.reset(new ThreadPool(num_workers_));
+    }
+}
+
+ParallelReducer::~ParallelReducer() {
+    if (pool_) {
+        pool_->JoinAll();
+    }
+}
+
+void ParallelReducer::PinWorker(const size_t& index) const {
+#ifdef __linux__
+    const uint32_t num_cores =
+        std::max(std::thread::hardware_concurrency(), 1U);
+    const int core = (first_core_ + index) % num_cores;
+    cpu_set_t pinned;
+    CPU_ZERO(&pinned);
+    CPU_SET(core, &pinned);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned) !=
+        0) {
+        LOG_F(WARNING, "failed to pin reduction worker %lu to core %d", index,
+              core);
+    }
+#endif
+}
+
+ReduceFunction ParallelReducer::Wrap(const ReduceFunction& reducer) {
+    if (pool_ == nullptr) {
+        return reducer;
+    }
+    return [this, reducer](Buffer src, Buffer dst) {
+        this->Reduce(src, dst, reducer);
+    };
+}
+
+void ParallelReducer::Reduce(Buffer src, Buffer dst,
+                             const ReduceFunction& reducer) {
+    const auto& size_in_bytes = src.size_in_bytes();
+    if (pool_ == nullptr || !dst.with_type() || size_in_bytes < min_size_) {
+        return reducer(src, dst);
+    }
+    const auto& item_size = dst.item_size();
+    const auto& count = size_in_bytes / item_size;
+    uint64_t part_items = (count + num_workers_) / (num_workers_ + 1);
+    if (kPartAlign % item_size == 0) {
+        const auto& align_items = kPartAlign / item_size;
+        part_items = (part_items + align_items - 1) / align_items * align_items;
+    }
+    auto part = [&src, &dst, item_size](const uint64_t& begin,
+                                        const uint64_t& end) {
+        auto src_part = src.Slice(begin * item_size, end * item_size);
+        auto dst_part = dst.Slice(begin * item_size, end * item_size);
+        src_part.set_item_size(item_size);
+        dst_part.set_item_size(item_size);
+        return std::make_pair(src_part, dst_part);
+    };
+    // signalled by workers, shared since a worker may still be inside Signal
+    // after the last Wait returns
+    auto done = std::make_shared<LightweightSemaphore>();
+    ssize_t num_tasks = 0;
+    for (uint64_t begin = part_items; begin < count; begin += part_items) {
+        auto bufs = part(begin, std::min(begin + part_items, count));
+        pool_->AddTask([reducer, bufs, done] {
+            reducer(bufs.first, bufs.second);
+            done->Signal();
+        });
+        ++num_tasks;
+    }
+    auto bufs = part(0, std::min(part_items, count));
+    reducer(bufs.first, bufs.second);
+    while (num_tasks > 0) {
+        num_tasks -= done->WaitMany(num_tasks);
+    }
+}
+}  // namespace comm
+}  // namespace rdc
@@ -0,0 +1,232 @@
+#ifdef RDC_USE_SHMEM
+#include "comm/shm_collective.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+#include "core/logging.h"
+
+namespace rdc {
+namespace comm {
+namespace {
+const uint32_t kArenaMagic = 0x52444341;
+// how long a rank waits for the lowest rank to create the arena
+const int kArenaAttachTimeoutMs = 60 * 1000;
+// polls before yielding, ranks may outnumber the cores of the host
+const int kSpinCount = 1024;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+template <typename Ready>
+inline void SpinUntil(Ready ready) {
+    for (int spins = 0; !ready(); ++spins) {
+        if (spins < kSpinCount) {
+            CpuRelax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+inline uint64_t AlignUp(const uint64_t& size) {
+    return (size + 63) / 64 * 64;
+}
+}  // namespace
+
+struct ShmCollectiveHeader {
+    alignas(64) std::atomic<uint32_t> magic;
+    std::atomic<int32_t> num_attached;
+    int32_t world_size;
+    uint64_t slot_size;
+};
+/**
+ * @brief: progress of one rank, only written by that rank, each counter
+ * holds the last round in which the rank passed the corresponding step
+ */
+struct ShmCollectiveFlags {
+    // its chunk is in its slot
+    alignas(64) std::atomic<uint64_t> arrived;
+    // its slice is reduced in its slot
+    std::atomic<uint64_t> reduced;
+    // it does not read any slot of the round anymore
+    std::atomic<uint64_t> done;
+};
+
+using RoundCounter = std::atomic<uint64_t> ShmCollectiveFlags::*;
+
+namespace {
+inline uint64_t ArenaSize(const int& world_size, const uint64_t& slot_size) {
+    return AlignUp(sizeof(ShmCollectiveHeader)) +
+           world_size * sizeof(ShmCollectiveFlags) +
+           world_size * 2 * slot_size;
+}
+
+inline void WaitAll(ShmCollectiveFlags* flags, const int& world_size,
+                    RoundCounter counter, const uint64_t& round) {
+    for (int i = 0; i < world_size; ++i) {
+        auto& flag = flags[i].*counter;
+        SpinUntil([&flag, round] {
+            return flag.load(std::memory_order_acquire) >= round;
+        });
+    }
+}
+}  // namespace
+
+ShmCollective::ShmCollective(const std::string& name, const int& rank,
+                             const int& world_size, const uint64_t& slot_size)
+    : name_(name),
+      rank_(rank),
+      world_size_(world_size),
+      slot_size_(slot_size),
+      round_(0),
+      header_(nullptr),
+      flags_(nullptr),
+      slots_(nullptr) {
+}
+
+ShmCollective::~ShmCollective() = default;
+
+bool ShmCollective::Attach() {
+    const auto& arena_size = ArenaSize(world_size_, slot_size_);
+    shm_.reset(new Shm(name_, arena_size));
+    if (rank_ == 0) {
+        if (shm_->Create() != kOK) {
+            LOG_F(ERROR, "failed to create shared memory %s",
+                  shm_->Path().c_str());
+            return false;
+        }
+        header_ = new (shm_->Data()) ShmCollectiveHeader;
+        header_->num_attached.store(0, std::memory_order_relaxed);
+        header_->world_size = world_size_;
+        header_->slot_size = slot_size_;
+        flags_ = reinterpret_cast<ShmCollectiveFlags*>(
+            shm_->Data() + AlignUp(sizeof(ShmCollectiveHeader)));
+        for (int i = 0; i < world_size_; ++i) {
+            new (flags_ + i) ShmCollectiveFlags;
+            flags_[i].arrived.store(0, std::memory_order_relaxed);
+            flags_[i].reduced.store(0, std::memory_order_relaxed);
+            flags_[i].done.store(0, std::memory_order_relaxed);
+        }
+        header_->magic.store(kArenaMagic, std::memory_order_release);
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        while (shm_->Open() != kOK ||
+               reinterpret_cast<ShmCollectiveHeader*>(shm_->Data())
+                       ->magic.load(std::memory_order_acquire) !=
+                   kArenaMagic) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(kArenaAttachTimeoutMs)) {
+                LOG_F(ERROR, "timeout waiting for shared memory %s",
+                      shm_->Path().c_str());
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            shm_.reset(new Shm(name_, arena_size));
+        }
+        header_ = reinterpret_cast<ShmCollectiveHeader*>(shm_->Data());
+        CHECK_F(header_->world_size == world_size_ &&
+                    header_->slot_size == slot_size_,
+                "RDC_IPC_COLL_SLOT_SIZE differs between ranks of %s",
+                name_.c_str());
+        flags_ = reinterpret_cast<ShmCollectiveFlags*>(
+            shm_->Data() + AlignUp(sizeof(ShmCollectiveHeader)));
+    }
+    slots_ = reinterpret_cast<uint8_t*>(flags_ + world_size_);
+    // everyone has it mapped, nothing else should find it
+    if (header_->num_attached.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+        world_size_) {
+        shm_->Unlink();
+    }
+    return true;
+}
+
+uint8_t* ShmCollective::slot(const int& rank) const {
+    return slots_ + (rank * 2 + round_ % 2) * slot_size_;
+}
+
+uint8_t* ShmCollective::BeginRound() {
+    ++round_;
+    // our slot was last used two rounds ago, wait until nobody reads it
+    if (round_ > 2) {
+        WaitAll(flags_, world_size_, &ShmCollectiveFlags::done, round_ - 2);
+    }
+    return slot(rank_);
+}
+
+void ShmCollective::Allreduce(Buffer sendrecvbuf, ReduceFunction reducer) {
+    const uint64_t item_size =
+        sendrecvbuf.with_type() ? sendrecvbuf.item_size() : 1;
+    const uint64_t chunk_size = slot_size_ / item_size * item_size;
+    CHECK_F(chunk_size != 0, "item of %lu bytes exceeds a slot", item_size);
+    auto* data = reinterpret_cast<uint8_t*>(sendrecvbuf.addr());
+    const auto& size_in_bytes = sendrecvbuf.size_in_bytes();
+    auto typed = [&sendrecvbuf](uint8_t* addr, const uint64_t& nbytes) {
+        Buffer buf(addr, nbytes);
+        if (sendrecvbuf.with_type()) {
+            buf.set_item_size(sendrecvbuf.item_size());
+        }
+        return buf;
+    };
+    for (uint64_t offset = 0; offset < size_in_bytes; offset += chunk_size) {
+        const uint64_t nbytes = std::min(chunk_size, size_in_bytes - offset);
+        const uint64_t count = nbytes / item_size;
+        // items [count * i / world_size, count * (i + 1) / world_size) are
+        // reduced by rank i
+        auto slice_begin = [&](const int& i) {
+            return count * i / world_size_ * item_size;
+        };
+        auto* mine = BeginRound();
+        std::memcpy(mine, data + offset, nbytes);
+        flags_[rank_].arrived.store(round_, std::memory_order_release);
+        WaitAll(flags_, world_size_, &ShmCollectiveFlags::arrived, round_);
+        const uint64_t begin = slice_begin(rank_);
+        const uint64_t end = slice_begin(rank_ + 1);
+        if (end > begin) {
+            for (int i = 1; i < world_size_; ++i) {
+                const int peer = (rank_ + i) % world_size_;
+                reducer(typed(slot(peer) + begin, end - begin),
+                        typed(mine + begin, end - begin));
+            }
+        }
+        flags_[rank_].reduced.store(round_, std::memory_order_release);
+        WaitAll(flags_, world_size_, &ShmCollectiveFlags::reduced, round_);
+        for (int i = 0; i < world_size_; ++i) {
+            std::memcpy(data + offset + slice_begin(i),
+                        slot(i) + slice_begin(i),
+                        slice_begin(i + 1) - slice_begin(i));
+        }
+        flags_[rank_].done.store(round_, std::memory_order_release);
+    }
+}
+
+void ShmCollective::Broadcast(Buffer sendrecvbuf, const int& root) {
+    auto* data = reinterpret_cast<uint8_t*>(sendrecvbuf.addr());
+    const auto& size_in_bytes = sendrecvbuf.size_in_bytes();
+    for (uint64_t offset = 0; offset < size_in_bytes; offset += slot_size_) {
+        const uint64_t nbytes = std::min(slot_size_, size_in_bytes - offset);
+        auto* mine = BeginRound();
+        if (rank_ == root) {
+            std::memcpy(mine, data + offset, nbytes);
+        }
+        flags_[rank_].arrived.store(round_, std::memory_order_release);
+        if (rank_ != root) {
+            auto& arrived = flags_[root].arrived;
+            const uint64_t round = round_;
+            SpinUntil([&arrived, round] {
+                return arrived.load(std::memory_order_acquire) >= round;
+            });
+            std::memcpy(data + offset, slot(root), nbytes);
+        }
+        flags_[rank_].reduced.store(round_, std::memory_order_release);
+        flags_[rank_].done.store(round_, std::memory_order_release);
+    }
+}
+}  // namespace comm
+}  // namespace rdc
+#endif
@@ -5,9 +5,6 @@
 #include "core/exception.h"
 #include "sys/network.h"
 #include "transport/adapter.h"
-#if RDC_USE_SHMEM
-#include "transport/ipc/ipc_adapter.h"
-#endif
 #include "utils/string_utils.h"
 namespace rdc {
 namespace comm {
@@ -119,10 +116,6 @@ std::tuple<int, int> Tracker::Connect(const char* cmd) {
         network::GetAvailableInterfaceAndIP(&interface, &ip);
         worker_port_ = network::GetAvailablePort();
         LOG_F(INFO, "Binding on port %d", worker_port_);
-#if RDC_USE_SHMEM
-        shmem_worker_port_ = network::GetAvailablePort();
-        LOG_F(INFO, "Binding on port %d", shmem_worker_port_);
-#endif
         this->host_uri_ = ip;
         // get information from tracker
 
@@ -154,10 +147,6 @@ std::tuple<int, int> Tracker::Connect(const char* cmd) {
         this->set_tracker_connected(true);
         // start listener at very begining
         GetAdapter()->Listen(worker_port_);
-#if RDC_USE_SHMEM
-        LOG_F(INFO, "Listening using IPC adapter");
-        IpcAdapter::Get()->Listen(shmem_worker_port_);
-#endif
     }
     tracker_sock_->SendStr(std::string(cmd));
     rank_ = Env::Get()->GetEnv("RDC_RANK", -1);
@@ -172,11 +161,6 @@ std::tuple<int, int> Tracker::Connect(const char* cmd) {
     auto host_addr = str_utils::SPrintf("%s:%s:%d", backend_str.c_str(),
                                         host_uri_.c_str(), worker_port_);
     tracker_sock_->SendStr(host_addr);
-#if RDC_USE_SHMEM
-    auto shmem_host_addr =
-        str_utils::SPrintf("ipc:%s:%d", host_uri_.c_str(), shmem_worker_port_);
-    tracker_sock_->SendStr(shmem_host_addr);
-#endif
 
     tracker_sock_->RecvInt(num_dead_nodes_);
     if (num_dead_nodes_ > 0) {
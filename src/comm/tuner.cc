@@ -0,0 +1,111 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file tuner.cc
+ * \brief implementation of collective tuning table
+ *
+ * \author Ankun Zheng
+ */
+#include "comm/tuner.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include "core/logging.h"
+
+namespace rdc {
+namespace comm {
+namespace {
+const std::vector<std::pair<std::string, AllreduceAlgo>> kAllreduceAlgoNames =
+    {{"auto", AllreduceAlgo::kAuto},
+     {"ring", AllreduceAlgo::kRing},
+     {"tree", AllreduceAlgo::kTree},
+     {"dtree", AllreduceAlgo::kDoubleTree},
+     {"rhd", AllreduceAlgo::kHalvingDoubling},
+     {"hier", AllreduceAlgo::kHierarchical}};
+}  // namespace
+
+bool AllreduceAlgoFromName(const std::string& name, AllreduceAlgo* algo) {
+    for (const auto& item : kAllreduceAlgoNames) {
+        if (item.first == name) {
+            *algo = item.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string AllreduceAlgoName(const AllreduceAlgo& algo) {
+    for (const auto& item : kAllreduceAlgoNames) {
+        if (item.second == algo) {
+            return item.first;
+        }
+    }
+    return "unknown";
+}
+
+AllreduceAlgo CollectiveTuner::Select(const uint64_t& size_in_bytes) const {
+    if (buckets_.empty()) {
+        return AllreduceAlgo::kAuto;
+    }
+    for (const auto& bucket : buckets_) {
+        if (size_in_bytes <= bucket.first) {
+            return bucket.second;
+        }
+    }
+    // larger than every measured size, keep the choice of the largest bucket
+    return buckets_.back().second;
+}
+
+void CollectiveTuner::Add(const uint64_t& max_size_in_bytes,
+                          const AllreduceAlgo& algo) {
+    CHECK_F(buckets_.empty() || buckets_.back().first < max_size_in_bytes,
+            "tuning buckets must be added in increasing size");
+    buckets_.emplace_back(max_size_in_bytes, algo);
+}
+
+bool CollectiveTuner::Load(const std::string& path) {
+    buckets_.clear();
+    FILE* fp = std::fopen(path.c_str(), "r");
+    if (fp == nullptr) {
+        LOG_F(WARNING, "cannot open tuning file %s", path.c_str());
+        return false;
+    }
+    char line[256], name[64];
+    uint64_t max_size = 0;
+    bool ok = true;
+    while (std::fgets(line, sizeof(line), fp) != nullptr) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        AllreduceAlgo algo;
+        if (sscanf(line, "%" SCNu64 " %63s", &max_size, name) != 2 ||
+            !AllreduceAlgoFromName(name, &algo) ||
+            (!buckets_.empty() && buckets_.back().first >= max_size)) {
+            LOG_F(ERROR, "invalid line in tuning file %s: %s", path.c_str(),
+                  line);
+            ok = false;
+            break;
+        }
+        buckets_.emplace_back(max_size, algo);
+    }
+    std::fclose(fp);
+    if (!ok) {
+        buckets_.clear();
+    }
+    return !buckets_.empty();
+}
+
+bool CollectiveTuner::Save(const std::string& path) const {
+    FILE* fp = std::fopen(path.c_str(), "w");
+    if (fp == nullptr) {
+        LOG_F(ERROR, "cannot write tuning file %s", path.c_str());
+        return false;
+    }
+    std::fprintf(fp, "# rdc allreduce tuning table: {max size in bytes} "
+                     "{algorithm}\n");
+    for (const auto& bucket : buckets_) {
+        std::fprintf(fp, "%" PRIu64 " %s\n", bucket.first,
+                     AllreduceAlgoName(bucket.second).c_str());
+    }
+    std::fclose(fp);
+    return true;
+}
+}  // namespace comm
+}  // namespace rdc
@@ -34,7 +34,8 @@ const char* Env::Find(const char* k) {
 
 std::shared_ptr<Env> Env::_GetSharedRef(
     const std::unordered_map<std::string, std::string>* envs) {
-    std::shared_ptr<Env> inst_ptr(new Env(envs));
+    // the first caller decides the content, later ones share it
+    static std::shared_ptr<Env> inst_ptr(new Env(envs));
     return inst_ptr;
 }
 
@@ -197,7 +197,7 @@ void Pool::ObjectPool::AllocateObjectArena() {
             size_);
     }
 
-    CHECK_NE(new_arena, reinterpret_cast<ObjectArena*>(
+    CHECK_EQ(new_arena, reinterpret_cast<ObjectArena*>(
                             reinterpret_cast<uintptr_t>(new_arena) &
                             ~(default_arena_size - 1)));
 
@@ -387,9 +387,9 @@ void Pool::ObjectPool::self_verify() {
             CHECK(arena->prev_arena->next_arena == arena);
     }
 
-    CHECK_NE(total_slots, total_slots_);
-    CHECK_NE(total_free, total_free_);
-    CHECK_NE(total_used, total_slots_ - total_free_);
+    CHECK_EQ(total_slots, total_slots_);
+    CHECK_EQ(total_free, total_free_);
+    CHECK_EQ(total_used, total_slots_ - total_free_);
 }
 
 /******************************************************************************/
@@ -500,9 +500,9 @@ void* Pool::ArenaFindFree(Arena* arena, size_t bin, size_t n, size_t bytes) {
 
         size_t new_bin = calc_bin_for_size(arena->free_size);
 
-        LOG_S(INFO) << "Recategorize arena, previous free "
-                    << arena->free_size + n << " now free " << arena->free_size
-                    << " from bin " << bin << " to bin " << new_bin;
+        VLOG_S(2) << "Recategorize arena, previous free "
+                  << arena->free_size + n << " now free " << arena->free_size
+                  << " from bin " << bin << " to bin " << new_bin;
         CHECK(bin != new_bin);
 
         // splice out arena from current bin
@@ -651,7 +651,7 @@ void* Pool::allocate(size_t bytes) {
     // check whether n is too large for allocation in our default Arenas, then
     // allocate a special larger one.
     if (n * sizeof(Slot) > bytes_per_arena(default_arena_size_)) {
-        LOG_S(INFO) << "Allocate overflow arena of size " << n * sizeof(Slot);
+        VLOG_S(2) << "Allocate overflow arena of size " << n * sizeof(Slot);
         Arena* sp_arena = AllocateFreeArena(sizeof(Arena) + n * sizeof(Slot));
 
         void* ptr = ArenaFindFree(sp_arena, num_bins, n, bytes);
@@ -662,7 +662,7 @@ void* Pool::allocate(size_t bytes) {
     // find bin for n slots
     size_t bin = calc_bin_for_size(n);
     while (bin < num_bins) {
-        LOG_S(INFO) << "Searching in bin " << bin;
+        VLOG_S(2) << "Searching in bin " << bin;
 
         Arena* curr_arena = arena_bin_[bin];
 
@@ -701,7 +701,7 @@ void Pool::deallocate(void* ptr, size_t bytes) {
         return;
 
     std::unique_lock<std::mutex> lock(mutex_);
-    LOG_S(INFO) << "Pool::deallocate() ptr " << ptr << " bytes " << bytes;
+    VLOG_S(2) << "Pool::deallocate() ptr " << ptr << " bytes " << bytes;
 
     if (debug_check_pairing) {
         size_t i;
@@ -4,8 +4,13 @@
 void ThreadPool::Run() {
     while (!bailout_) {
         NextJob()();
-        --jobs_left_;
-        wait_var_.notify_one();
+        // under the lock of the waiters, one which just saw jobs left would
+        // miss the wakeup otherwise
+        {
+            std::lock_guard<std::mutex> wait_lock(wait_mutex_);
+            --jobs_left_;
+        }
+        wait_var_.notify_all();
     }
 }
 
@@ -31,10 +36,21 @@ ThreadPool::Task ThreadPool::NextJob() {
 }
 
 ThreadPool::ThreadPool(const size_t& num_workers)
+    : ThreadPool(num_workers, nullptr) {
+}
+
+ThreadPool::ThreadPool(const size_t& num_workers,
+                       const WorkerInit& worker_init)
     : jobs_left_(0), bailout_(false), finished_(false) {
     std::unique_lock<std::mutex> worker_lock(worker_mutex_);
-    for (auto i = 0; i < num_workers; ++i) {
-        workers_.emplace_back(std::thread([this] { return this->Run(); }));
+    num_workers_ = num_workers;
+    for (auto i = 0U; i < num_workers; ++i) {
+        workers_.emplace_back(std::thread([this, i, worker_init] {
+            if (worker_init) {
+                worker_init(i);
+            }
+            return this->Run();
+        }));
     }
 }
 
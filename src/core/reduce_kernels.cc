@@ -0,0 +1,568 @@
+/*!
+ * Copyright by Contributors
+ * \file reduce_kernels.cc
+ * \brief vectorized kernels of the built-in reduction operators
+ *
+ *  every instruction set gets a traits class per data type which wraps the
+ *  unaligned load/store and one Apply overload per supported operator, the
+ *  same loop is then stamped out for each instruction set with the matching
+ *  target attribute, so that no translation unit needs extra compile flags
+ *
+ *  16 bit floating point types are widened to single precision on load and
+ *  rounded back on store, so their vectors are single precision vectors and
+ *  the operators are the single precision ones
+ *
+ * \author Ankun Zheng
+ */
+#include "core/reduce_kernels.h"
+#include <type_traits>
+#include <utility>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RDC_REDUCE_KERNELS_X86 1
+#endif
+
+namespace rdc {
+namespace op {
+namespace {
+// traits of a data type on an instruction set, left empty when the
+// instruction set has nothing to offer
+template <typename Isa, typename DType>
+struct VecTraits {};
+
+// whether traits provide a vectorized version of an operator
+template <typename Traits, typename OP, typename = void>
+struct HasApply : std::false_type {};
+template <typename Traits, typename OP>
+struct HasApply<Traits, OP,
+                decltype(void(Traits::Apply(
+                    OP(), std::declval<typename Traits::Vec>(),
+                    std::declval<typename Traits::Vec>())))>
+    : std::true_type {};
+
+template <typename DType>
+struct IsFloatType
+    : std::integral_constant<bool, std::is_floating_point<DType>::value ||
+                                       std::is_same<DType, Half>::value ||
+                                       std::is_same<DType, BFloat16>::value> {
+};
+// operators which are defined on a data type
+template <typename OP, typename DType>
+struct IsValidOp
+    : std::integral_constant<bool, !(std::is_same<OP, BitOR>::value &&
+                                     IsFloatType<DType>::value)> {};
+
+template <typename OP, typename DType>
+ReduceKernel ScalarKernel(std::true_type) {
+    return &Reducer<OP, DType>;
+}
+template <typename OP, typename DType>
+ReduceKernel ScalarKernel(std::false_type) {
+    return nullptr;
+}
+
+#if RDC_REDUCE_KERNELS_X86
+struct IsaSse41 {};
+struct IsaAvx2 {};
+struct IsaAvx512 {};
+
+#define RDC_TARGET_SSE41 __attribute__((target("sse4.1")))
+// every cpu with avx2 so far also has f16c, required for half conversion
+#define RDC_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#define RDC_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+// common part of all traits: vector type, lanes, load and store
+#define RDC_VEC_TRAITS_BEGIN(ISA, T, VEC, TARGET, LOAD, STORE) \
+    template <>                                                 \
+    struct VecTraits<ISA, T> {                                  \
+        using DType = T;                                        \
+        using Vec = VEC;                                        \
+        static constexpr uint64_t kLanes = sizeof(VEC) / sizeof(T); \
+        TARGET static inline Vec Load(const T* p) {             \
+            return LOAD;                                        \
+        }                                                       \
+        TARGET static inline void Store(T* p, Vec v) {          \
+            STORE;                                              \
+        }
+// max and min take src first so that NaN keeps dst like the scalar loop
+#define RDC_VEC_APPLY(TARGET, OP, EXPR)                          \
+    TARGET static inline Vec Apply(OP, Vec dst, Vec src) {       \
+        return EXPR;                                             \
+    }
+#define RDC_VEC_TRAITS_END \
+    }                      \
+    ;
+// 16 bit floating point types on single precision vectors, LOAD widens lanes
+// 16 bit values at p, STORE rounds v back
+#define RDC_VEC_HALF_TRAITS_BEGIN(ISA, T, VEC, TARGET, LOAD, STORE) \
+    template <>                                                      \
+    struct VecTraits<ISA, T> {                                       \
+        using DType = T;                                             \
+        using Vec = VEC;                                             \
+        static constexpr uint64_t kLanes = sizeof(VEC) / sizeof(float); \
+        TARGET static inline Vec Load(const T* p) {                  \
+            return LOAD;                                             \
+        }                                                            \
+        TARGET static inline void Store(T* p, Vec v) {               \
+            STORE;                                                   \
+        }
+#define RDC_VEC_FLOAT_OPS(TARGET, ADD, MAX, MIN)        \
+    RDC_VEC_APPLY(TARGET, Sum, ADD(dst, src))           \
+    RDC_VEC_APPLY(TARGET, Max, MAX(src, dst))           \
+    RDC_VEC_APPLY(TARGET, Min, MIN(src, dst))
+
+// ---------------------------- SSE4.1 ----------------------------
+#define RDC_SSE_INT_TRAITS(T, ADD)                                         \
+    RDC_VEC_TRAITS_BEGIN(IsaSse41, T, __m128i, RDC_TARGET_SSE41,           \
+                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), \
+                         _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v)) \
+    RDC_VEC_APPLY(RDC_TARGET_SSE41, Sum, ADD(dst, src))                    \
+    RDC_VEC_APPLY(RDC_TARGET_SSE41, BitOR, _mm_or_si128(dst, src))
+#define RDC_SSE_INT_MINMAX(MAX, MIN)                       \
+    RDC_VEC_APPLY(RDC_TARGET_SSE41, Max, MAX(src, dst))    \
+    RDC_VEC_APPLY(RDC_TARGET_SSE41, Min, MIN(src, dst))
+
+RDC_SSE_INT_TRAITS(char, _mm_add_epi8)
+RDC_SSE_INT_MINMAX(_mm_max_epi8, _mm_min_epi8)
+RDC_VEC_TRAITS_END
+RDC_SSE_INT_TRAITS(unsigned char, _mm_add_epi8)
+RDC_SSE_INT_MINMAX(_mm_max_epu8, _mm_min_epu8)
+RDC_VEC_TRAITS_END
+RDC_SSE_INT_TRAITS(int, _mm_add_epi32)
+RDC_SSE_INT_MINMAX(_mm_max_epi32, _mm_min_epi32)
+RDC_VEC_TRAITS_END
+RDC_SSE_INT_TRAITS(unsigned int, _mm_add_epi32)  // NOLINT(*)
+RDC_SSE_INT_MINMAX(_mm_max_epu32, _mm_min_epu32)
+RDC_VEC_TRAITS_END
+// no 64 bit integer compare below AVX-512, max and min stay scalar
+RDC_SSE_INT_TRAITS(long, _mm_add_epi64)  // NOLINT(*)
+RDC_VEC_TRAITS_END
+RDC_SSE_INT_TRAITS(unsigned long, _mm_add_epi64)  // NOLINT(*)
+RDC_VEC_TRAITS_END
+RDC_SSE_INT_TRAITS(long long, _mm_add_epi64)  // NOLINT(*)
+RDC_VEC_TRAITS_END
+RDC_SSE_INT_TRAITS(unsigned long long, _mm_add_epi64)  // NOLINT(*)
+RDC_VEC_TRAITS_END
+
+RDC_VEC_TRAITS_BEGIN(IsaSse41, float, __m128, RDC_TARGET_SSE41,
+                     _mm_loadu_ps(p), _mm_storeu_ps(p, v))
+RDC_VEC_APPLY(RDC_TARGET_SSE41, Sum, _mm_add_ps(dst, src))
+RDC_VEC_APPLY(RDC_TARGET_SSE41, Max, _mm_max_ps(src, dst))
+RDC_VEC_APPLY(RDC_TARGET_SSE41, Min, _mm_min_ps(src, dst))
+RDC_VEC_TRAITS_END
+RDC_VEC_TRAITS_BEGIN(IsaSse41, double, __m128d, RDC_TARGET_SSE41,
+                     _mm_loadu_pd(p), _mm_storeu_pd(p, v))
+RDC_VEC_APPLY(RDC_TARGET_SSE41, Sum, _mm_add_pd(dst, src))
+RDC_VEC_APPLY(RDC_TARGET_SSE41, Max, _mm_max_pd(src, dst))
+RDC_VEC_APPLY(RDC_TARGET_SSE41, Min, _mm_min_pd(src, dst))
+RDC_VEC_TRAITS_END
+
+// bfloat16 is the upper half of a float, rounding adds 0x7fff plus the
+// lowest kept bit before truncation, nan is only made quiet
+RDC_TARGET_SSE41 static inline __m128 BFloat16ToPs(const BFloat16* p) {
+    __m128i bits = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm_castsi128_ps(_mm_slli_epi32(_mm_cvtepu16_epi32(bits), 16));
+}
+RDC_TARGET_SSE41 static inline void PsToBFloat16(BFloat16* p, __m128 v) {
+    __m128i x = _mm_castps_si128(v);
+    __m128i high = _mm_srli_epi32(x, 16);
+    __m128i round = _mm_add_epi32(_mm_and_si128(high, _mm_set1_epi32(1)),
+                                  _mm_set1_epi32(0x7FFF));
+    __m128i bits = _mm_srli_epi32(_mm_add_epi32(x, round), 16);
+    __m128i qnan = _mm_or_si128(high, _mm_set1_epi32(0x40));
+    bits = _mm_blendv_epi8(bits, qnan, _mm_castps_si128(_mm_cmpunord_ps(v, v)));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi32(bits, bits));
+}
+RDC_VEC_HALF_TRAITS_BEGIN(IsaSse41, BFloat16, __m128, RDC_TARGET_SSE41,
+                          BFloat16ToPs(p), PsToBFloat16(p, v))
+RDC_VEC_FLOAT_OPS(RDC_TARGET_SSE41, _mm_add_ps, _mm_max_ps, _mm_min_ps)
+RDC_VEC_TRAITS_END
+
+// ----------------------------- AVX2 -----------------------------
+#define RDC_AVX2_INT_TRAITS(T, ADD)                                        \
+    RDC_VEC_TRAITS_BEGIN(                                                  \
+        IsaAvx2, T, __m256i, RDC_TARGET_AVX2,                              \
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)),           \
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v))             \
+    RDC_VEC_APPLY(RDC_TARGET_AVX2, Sum, ADD(dst, src))                     \
+    RDC_VEC_APPLY(RDC_TARGET_AVX2, BitOR, _mm256_or_si256(dst, src))
+#define RDC_AVX2_INT_MINMAX(MAX, MIN)                     \
+    RDC_VEC_APPLY(RDC_TARGET_AVX2, Max, MAX(src, dst))    \
+    RDC_VEC_APPLY(RDC_TARGET_AVX2, Min, MIN(src, dst))
+
+RDC_AVX2_INT_TRAITS(char, _mm256_add_epi8)
+RDC_AVX2_INT_MINMAX(_mm256_max_epi8, _mm256_min_epi8)
+RDC_VEC_TRAITS_END
+RDC_AVX2_INT_TRAITS(unsigned char, _mm256_add_epi8)
+RDC_AVX2_INT_MINMAX(_mm256_max_epu8, _mm256_min_epu8)
+RDC_VEC_TRAITS_END
+RDC_AVX2_INT_TRAITS(int, _mm256_add_epi32)
+RDC_AVX2_INT_MINMAX(_mm256_max_epi32, _mm256_min_epi32)
+RDC_VEC_TRAITS_END
+RDC_AVX2_INT_TRAITS(unsigned int, _mm256_add_epi32)  // NOLINT(*)
+RDC_AVX2_INT_MINMAX(_mm256_max_epu32, _mm256_min_epu32)
+RDC_VEC_TRAITS_END
+RDC_AVX2_INT_TRAITS(long, _mm256_add_epi64)  // NOLINT(*)
+RDC_VEC_TRAITS_END
+RDC_AVX2_INT_TRAITS(unsigned long, _mm256_add_epi64)  // NOLINT(*)
+RDC_VEC_TRAITS_END
+RDC_AVX2_INT_TRAITS(long long, _mm256_add_epi64)  // NOLINT(*)
+RDC_VEC_TRAITS_END
+RDC_AVX2_INT_TRAITS(unsigned long long, _mm256_add_epi64)  // NOLINT(*)
+RDC_VEC_TRAITS_END
+
+RDC_VEC_TRAITS_BEGIN(IsaAvx2, float, __m256, RDC_TARGET_AVX2,
+                     _mm256_loadu_ps(p), _mm256_storeu_ps(p, v))
+RDC_VEC_APPLY(RDC_TARGET_AVX2, Sum, _mm256_add_ps(dst, src))
+RDC_VEC_APPLY(RDC_TARGET_AVX2, Max, _mm256_max_ps(src, dst))
+RDC_VEC_APPLY(RDC_TARGET_AVX2, Min, _mm256_min_ps(src, dst))
+RDC_VEC_TRAITS_END
+RDC_VEC_TRAITS_BEGIN(IsaAvx2, double, __m256d, RDC_TARGET_AVX2,
+                     _mm256_loadu_pd(p), _mm256_storeu_pd(p, v))
+RDC_VEC_APPLY(RDC_TARGET_AVX2, Sum, _mm256_add_pd(dst, src))
+RDC_VEC_APPLY(RDC_TARGET_AVX2, Max, _mm256_max_pd(src, dst))
+RDC_VEC_APPLY(RDC_TARGET_AVX2, Min, _mm256_min_pd(src, dst))
+RDC_VEC_TRAITS_END
+
+RDC_VEC_HALF_TRAITS_BEGIN(
+    IsaAvx2, Half, __m256, RDC_TARGET_AVX2,
+    _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                     _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT)))
+RDC_VEC_FLOAT_OPS(RDC_TARGET_AVX2, _mm256_add_ps, _mm256_max_ps,
+                  _mm256_min_ps)
+RDC_VEC_TRAITS_END
+
+RDC_TARGET_AVX2 static inline __m256 BFloat16ToPs256(const BFloat16* p) {
+    __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    return _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_cvtepu16_epi32(bits), 16));
+}
+RDC_TARGET_AVX2 static inline void Ps256ToBFloat16(BFloat16* p, __m256 v) {
+    __m256i x = _mm256_castps_si256(v);
+    __m256i high = _mm256_srli_epi32(x, 16);
+    __m256i round = _mm256_add_epi32(
+        _mm256_and_si256(high, _mm256_set1_epi32(1)),
+        _mm256_set1_epi32(0x7FFF));
+    __m256i bits = _mm256_srli_epi32(_mm256_add_epi32(x, round), 16);
+    __m256i qnan = _mm256_or_si256(high, _mm256_set1_epi32(0x40));
+    bits = _mm256_blendv_epi8(
+        bits, qnan, _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                     _mm_packus_epi32(_mm256_castsi256_si128(bits),
+                                      _mm256_extracti128_si256(bits, 1)));
+}
+RDC_VEC_HALF_TRAITS_BEGIN(IsaAvx2, BFloat16, __m256, RDC_TARGET_AVX2,
+                          BFloat16ToPs256(p), Ps256ToBFloat16(p, v))
+RDC_VEC_FLOAT_OPS(RDC_TARGET_AVX2, _mm256_add_ps, _mm256_max_ps,
+                  _mm256_min_ps)
+RDC_VEC_TRAITS_END
+
+// ---------------------------- AVX-512 ---------------------------
+#define RDC_AVX512_INT_TRAITS(T, ADD, MAX, MIN)                           \
+    RDC_VEC_TRAITS_BEGIN(IsaAvx512, T, __m512i, RDC_TARGET_AVX512,        \
+                         _mm512_loadu_si512(p), _mm512_storeu_si512(p, v)) \
+    RDC_VEC_APPLY(RDC_TARGET_AVX512, Sum, ADD(dst, src))                  \
+    RDC_VEC_APPLY(RDC_TARGET_AVX512, BitOR, _mm512_or_si512(dst, src))    \
+    RDC_VEC_APPLY(RDC_TARGET_AVX512, Max, MAX(src, dst))                  \
+    RDC_VEC_APPLY(RDC_TARGET_AVX512, Min, MIN(src, dst))                  \
+    RDC_VEC_TRAITS_END
+
+RDC_AVX512_INT_TRAITS(char, _mm512_add_epi8, _mm512_max_epi8, _mm512_min_epi8)
+RDC_AVX512_INT_TRAITS(unsigned char, _mm512_add_epi8, _mm512_max_epu8,
+                      _mm512_min_epu8)
+RDC_AVX512_INT_TRAITS(int, _mm512_add_epi32, _mm512_max_epi32,
+                      _mm512_min_epi32)
+RDC_AVX512_INT_TRAITS(unsigned int, _mm512_add_epi32,  // NOLINT(*)
+                      _mm512_max_epu32, _mm512_min_epu32)
+RDC_AVX512_INT_TRAITS(long, _mm512_add_epi64,  // NOLINT(*)
+                      _mm512_max_epi64, _mm512_min_epi64)
+RDC_AVX512_INT_TRAITS(unsigned long, _mm512_add_epi64,  // NOLINT(*)
+                      _mm512_max_epu64, _mm512_min_epu64)
+RDC_AVX512_INT_TRAITS(long long, _mm512_add_epi64,  // NOLINT(*)
+                      _mm512_max_epi64, _mm512_min_epi64)
+RDC_AVX512_INT_TRAITS(unsigned long long, _mm512_add_epi64,  // NOLINT(*)
+                      _mm512_max_epu64, _mm512_min_epu64)
+
+RDC_VEC_TRAITS_BEGIN(IsaAvx512, float, __m512, RDC_TARGET_AVX512,
+                     _mm512_loadu_ps(p), _mm512_storeu_ps(p, v))
+RDC_VEC_APPLY(RDC_TARGET_AVX512, Sum, _mm512_add_ps(dst, src))
+RDC_VEC_APPLY(RDC_TARGET_AVX512, Max, _mm512_max_ps(src, dst))
+RDC_VEC_APPLY(RDC_TARGET_AVX512, Min, _mm512_min_ps(src, dst))
+RDC_VEC_TRAITS_END
+RDC_VEC_TRAITS_BEGIN(IsaAvx512, double, __m512d, RDC_TARGET_AVX512,
+                     _mm512_loadu_pd(p), _mm512_storeu_pd(p, v))
+RDC_VEC_APPLY(RDC_TARGET_AVX512, Sum, _mm512_add_pd(dst, src))
+RDC_VEC_APPLY(RDC_TARGET_AVX512, Max, _mm512_max_pd(src, dst))
+RDC_VEC_APPLY(RDC_TARGET_AVX512, Min, _mm512_min_pd(src, dst))
+RDC_VEC_TRAITS_END
+
+RDC_VEC_HALF_TRAITS_BEGIN(
+    IsaAvx512, Half, __m512, RDC_TARGET_AVX512,
+    _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))),
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p),
+                        _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT)))
+RDC_VEC_FLOAT_OPS(RDC_TARGET_AVX512, _mm512_add_ps, _mm512_max_ps,
+                  _mm512_min_ps)
+RDC_VEC_TRAITS_END
+
+RDC_TARGET_AVX512 static inline __m512 BFloat16ToPs512(const BFloat16* p) {
+    __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    return _mm512_castsi512_ps(
+        _mm512_slli_epi32(_mm512_cvtepu16_epi32(bits), 16));
+}
+RDC_TARGET_AVX512 static inline void Ps512ToBFloat16(BFloat16* p, __m512 v) {
+    __m512i x = _mm512_castps_si512(v);
+    __m512i high = _mm512_srli_epi32(x, 16);
+    __m512i round = _mm512_add_epi32(
+        _mm512_and_si512(high, _mm512_set1_epi32(1)),
+        _mm512_set1_epi32(0x7FFF));
+    __m512i bits = _mm512_srli_epi32(_mm512_add_epi32(x, round), 16);
+    __m512i qnan = _mm512_or_si512(high, _mm512_set1_epi32(0x40));
+    bits = _mm512_mask_blend_epi32(_mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q),
+                                   bits, qnan);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p),
+                        _mm512_cvtepi32_epi16(bits));
+}
+RDC_VEC_HALF_TRAITS_BEGIN(IsaAvx512, BFloat16, __m512, RDC_TARGET_AVX512,
+                          BFloat16ToPs512(p), Ps512ToBFloat16(p, v))
+RDC_VEC_FLOAT_OPS(RDC_TARGET_AVX512, _mm512_add_ps, _mm512_max_ps,
+                  _mm512_min_ps)
+RDC_VEC_TRAITS_END
+
+// the reduction loop, two vectors per iteration to hide load latency, the
+// tail is handled by the scalar operator
+#define RDC_DEFINE_VEC_KERNEL(NAME, TARGET)                                \
+    template <typename OP, typename Traits>                                \
+    TARGET void NAME(const void* src_, void* dst_, uint64_t len) {         \
+        using DType = typename Traits::DType;                              \
+        const uint64_t kLanes = Traits::kLanes;                            \
+        const DType* src = reinterpret_cast<const DType*>(src_);           \
+        DType* dst = reinterpret_cast<DType*>(dst_);                       \
+        uint64_t i = 0;                                                    \
+        for (; i + 2 * kLanes <= len; i += 2 * kLanes) {                   \
+            auto dst0 = Traits::Load(dst + i);                             \
+            auto dst1 = Traits::Load(dst + i + kLanes);                    \
+            auto src0 = Traits::Load(src + i);                             \
+            auto src1 = Traits::Load(src + i + kLanes);                    \
+            Traits::Store(dst + i, Traits::Apply(OP(), dst0, src0));       \
+            Traits::Store(dst + i + kLanes,                                \
+                          Traits::Apply(OP(), dst1, src1));                \
+        }                                                                  \
+        for (; i + kLanes <= len; i += kLanes) {                           \
+            Traits::Store(dst + i,                                         \
+                          Traits::Apply(OP(), Traits::Load(dst + i),       \
+                                        Traits::Load(src + i)));           \
+        }                                                                  \
+        for (; i < len; ++i) {                                             \
+            OP::Reduce(dst[i], src[i]);                                    \
+        }                                                                  \
+    }
+
+RDC_DEFINE_VEC_KERNEL(VecKernelSse41, RDC_TARGET_SSE41)
+RDC_DEFINE_VEC_KERNEL(VecKernelAvx2, RDC_TARGET_AVX2)
+RDC_DEFINE_VEC_KERNEL(VecKernelAvx512, RDC_TARGET_AVX512)
+
+// conversion between two types whose traits share the vector type
+#define RDC_DEFINE_CONVERT_KERNEL(NAME, TARGET)                            \
+    template <typename SrcTraits, typename DstTraits>                      \
+    TARGET void NAME(const void* src_, void* dst_, uint64_t len) {         \
+        using SrcType = typename SrcTraits::DType;                         \
+        using DstType = typename DstTraits::DType;                         \
+        const uint64_t kLanes = SrcTraits::kLanes;                         \
+        const SrcType* src = reinterpret_cast<const SrcType*>(src_);       \
+        DstType* dst = reinterpret_cast<DstType*>(dst_);                   \
+        uint64_t i = 0;                                                    \
+        for (; i + kLanes <= len; i += kLanes) {                           \
+            DstTraits::Store(dst + i, SrcTraits::Load(src + i));           \
+        }                                                                  \
+        for (; i < len; ++i) {                                             \
+            dst[i] = DstType(static_cast<float>(src[i]));                  \
+        }                                                                  \
+    }
+
+RDC_DEFINE_CONVERT_KERNEL(ConvertKernelSse41, RDC_TARGET_SSE41)
+RDC_DEFINE_CONVERT_KERNEL(ConvertKernelAvx2, RDC_TARGET_AVX2)
+RDC_DEFINE_CONVERT_KERNEL(ConvertKernelAvx512, RDC_TARGET_AVX512)
+
+template <typename Isa>
+struct IsaKernels;
+template <>
+struct IsaKernels<IsaSse41> {
+    template <typename OP, typename DType>
+    static ReduceKernel Get() {
+        return &VecKernelSse41<OP, VecTraits<IsaSse41, DType>>;
+    }
+};
+template <>
+struct IsaKernels<IsaAvx2> {
+    template <typename OP, typename DType>
+    static ReduceKernel Get() {
+        return &VecKernelAvx2<OP, VecTraits<IsaAvx2, DType>>;
+    }
+};
+template <>
+struct IsaKernels<IsaAvx512> {
+    template <typename OP, typename DType>
+    static ReduceKernel Get() {
+        return &VecKernelAvx512<OP, VecTraits<IsaAvx512, DType>>;
+    }
+};
+
+template <typename Isa, typename OP, typename DType>
+ReduceKernel IsaKernel(std::true_type) {
+    return IsaKernels<Isa>::template Get<OP, DType>();
+}
+template <typename Isa, typename OP, typename DType>
+ReduceKernel IsaKernel(std::false_type) {
+    return nullptr;
+}
+/*! \brief vectorized kernel of an instruction set, nullptr if none */
+template <typename Isa, typename OP, typename DType>
+ReduceKernel IsaKernel() {
+    return IsaKernel<Isa, OP, DType>(
+        HasApply<VecTraits<Isa, DType>, OP>());
+}
+#endif  // RDC_REDUCE_KERNELS_X86
+
+enum class IsaLevel : int {
+    kScalar = 0,
+    kSse41 = 1,
+    kAvx2 = 2,
+    kAvx512 = 3,
+};
+
+IsaLevel DetectIsa() {
+#if RDC_REDUCE_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512bw")) {
+        return IsaLevel::kAvx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+        return IsaLevel::kAvx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return IsaLevel::kSse41;
+    }
+#endif
+    return IsaLevel::kScalar;
+}
+
+template <typename OP, typename DType>
+ReduceKernel SelectKernel(const IsaLevel& isa) {
+    ReduceKernel kernel = nullptr;
+#if RDC_REDUCE_KERNELS_X86
+    // fall back to a narrower instruction set when the operator has no
+    // vectorized version on the wider one, e.g. 64 bit max below AVX-512
+    if (isa >= IsaLevel::kAvx512) {
+        kernel = IsaKernel<IsaAvx512, OP, DType>();
+    }
+    if (kernel == nullptr && isa >= IsaLevel::kAvx2) {
+        kernel = IsaKernel<IsaAvx2, OP, DType>();
+    }
+    if (kernel == nullptr && isa >= IsaLevel::kSse41) {
+        kernel = IsaKernel<IsaSse41, OP, DType>();
+    }
+#endif
+    if (kernel == nullptr) {
+        kernel = ScalarKernel<OP, DType>(IsValidOp<OP, DType>());
+    }
+    return kernel;
+}
+
+template <typename SrcType, typename DstType>
+void ScalarConvertKernel(const void* src_, void* dst_, uint64_t len) {
+    const SrcType* src = reinterpret_cast<const SrcType*>(src_);
+    DstType* dst = reinterpret_cast<DstType*>(dst_);
+    for (uint64_t i = 0; i < len; ++i) {
+        dst[i] = DstType(static_cast<float>(src[i]));
+    }
+}
+
+template <typename SrcType, typename DstType>
+ReduceKernel SelectConvertKernel(const IsaLevel& isa) {
+#if RDC_REDUCE_KERNELS_X86
+    if (isa >= IsaLevel::kAvx512) {
+        return &ConvertKernelAvx512<VecTraits<IsaAvx512, SrcType>,
+                                    VecTraits<IsaAvx512, DstType>>;
+    }
+    if (isa >= IsaLevel::kAvx2) {
+        return &ConvertKernelAvx2<VecTraits<IsaAvx2, SrcType>,
+                                  VecTraits<IsaAvx2, DstType>>;
+    }
+    if (isa >= IsaLevel::kSse41) {
+        return &ConvertKernelSse41<VecTraits<IsaSse41, SrcType>,
+                                   VecTraits<IsaSse41, DstType>>;
+    }
+#endif
+    return &ScalarConvertKernel<SrcType, DstType>;
+}
+
+const int kNumOpTypes = 4;
+const int kNumDataTypes = 12;
+
+struct KernelTable {
+    KernelTable() : isa(DetectIsa()) {
+        Fill<char>(mpi::kChar);
+        Fill<unsigned char>(mpi::kUChar);
+        Fill<int>(mpi::kInt);
+        Fill<unsigned int>(mpi::kUInt);        // NOLINT(*)
+        Fill<long>(mpi::kLong);                // NOLINT(*)
+        Fill<unsigned long>(mpi::kULong);      // NOLINT(*)
+        Fill<float>(mpi::kFloat);
+        Fill<double>(mpi::kDouble);
+        Fill<long long>(mpi::kLongLong);       // NOLINT(*)
+        Fill<unsigned long long>(mpi::kULongLong);  // NOLINT(*)
+        Fill<Half>(mpi::kHalf);
+        Fill<BFloat16>(mpi::kBFloat16);
+        to_bfloat16 = SelectConvertKernel<float, BFloat16>(isa);
+        from_bfloat16 = SelectConvertKernel<BFloat16, float>(isa);
+    }
+    template <typename DType>
+    void Fill(const mpi::DataType& dtype) {
+        kernels[dtype][mpi::kMax] = SelectKernel<Max, DType>(isa);
+        kernels[dtype][mpi::kMin] = SelectKernel<Min, DType>(isa);
+        kernels[dtype][mpi::kSum] = SelectKernel<Sum, DType>(isa);
+        kernels[dtype][mpi::kBitwiseOR] = SelectKernel<BitOR, DType>(isa);
+    }
+    IsaLevel isa;
+    ReduceKernel kernels[kNumDataTypes][kNumOpTypes];
+    ReduceKernel to_bfloat16;
+    ReduceKernel from_bfloat16;
+};
+
+const KernelTable& GetKernelTable() {
+    // built once, function local statics are initialized thread safely
+    static KernelTable table;
+    return table;
+}
+}  // namespace
+
+ReduceKernel GetReduceKernel(const mpi::OpType& op,
+                             const mpi::DataType& dtype) {
+    return GetKernelTable().kernels[dtype][op];
+}
+
+void FloatToBFloat16(const float* src, BFloat16* dst, uint64_t len) {
+    GetKernelTable().to_bfloat16(src, dst, len);
+}
+
+void BFloat16ToFloat(const BFloat16* src, float* dst, uint64_t len) {
+    GetKernelTable().from_bfloat16(src, dst, len);
+}
+
+const char* ReduceKernelIsa() {
+    switch (GetKernelTable().isa) {
+        case IsaLevel::kAvx512:
+            return "avx512";
+        case IsaLevel::kAvx2:
+            return "avx2";
+        case IsaLevel::kSse41:
+            return "sse4.1";
+        default:
+            return "scalar";
+    }
+}
+}  // namespace op
+}  // namespace rdc
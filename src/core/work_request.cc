@@ -1,49 +1,56 @@
 #include "core/work_request.h"
+#include <algorithm>
+#include "common/env.h"
 
 namespace rdc {
-WorkRequest::WorkRequest()
-    : status_(WorkStatus::kPending), processed_bytes_upto_now_(0) {
-}
-
-WorkRequest::WorkRequest(const uint64_t& req_id, const WorkType& work_type,
-                         void* ptr, const size_t& size)
-    : req_id_(req_id),
-      work_type_(work_type),
-      status_(WorkStatus::kPending),
-      ptr_(ptr),
-      size_in_bytes_(size),
-      processed_bytes_upto_now_(0) {
-}
+namespace {
+// outstanding work requests, one slot each
+const uint32_t kDefaultWorkRequestCapacity = 1 << 20;
+}  // namespace
 
-WorkRequest::WorkRequest(const uint64_t& req_id, const WorkType& work_type,
-                         const void* ptr, const size_t& size)
-    : req_id_(req_id),
-      work_type_(work_type),
+WorkRequest::WorkRequest()
+    : req_id_(0),
+      work_type_(WorkType::kSend),
+      ptr_(nullptr),
+      size_in_bytes_(0),
+      processed_bytes_upto_now_(0),
       status_(WorkStatus::kPending),
-      ptr_(const_cast<void*>(ptr)),
-      size_in_bytes_(size),
-      processed_bytes_upto_now_(0) {
+      callbacks_run_(false),
+      refs_(0),
+      done_(true),
+      next_free_(0) {
+}
+
+void WorkRequest::Reset(const uint64_t& req_id, const WorkType& work_type,
+                        void* ptr, const size_t& size) {
+    req_id_ = req_id;
+    work_type_ = work_type;
+    ptr_ = ptr;
+    size_in_bytes_ = size;
+    processed_bytes_upto_now_ = 0;
+    extra_data_ = any();
+    done_callbacks_.clear();
+    callbacks_run_ = false;
+    wait_callback_ = nullptr;
+    // drop notifications left over from earlier requests of this slot
+    while (sema_.TryWait()) {
+    }
+    refs_.store(2, std::memory_order_relaxed);
+    done_.store(false, std::memory_order_relaxed);
+    status_.store(WorkStatus::kPending, std::memory_order_release);
 }
 
-WorkRequest::WorkRequest(const WorkRequest& other) {
-    req_id_ = other.req_id_;
-    ptr_ = other.ptr_;
-    size_in_bytes_ = other.size_in_bytes_;
-    work_type_ = other.work_type_;
-    processed_bytes_upto_now_ = other.processed_bytes_upto_now_;
-    set_status(other.status());
-    extra_data_ = other.extra_data_;
+void WorkRequest::Unref() {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        WorkRequestManager::Get()->FreeSlot(
+            static_cast<uint32_t>(req_id_ & UINT32_MAX));
+    }
 }
 
-WorkRequest& WorkRequest::operator=(const WorkRequest& other) {
-    req_id_ = other.req_id_;
-    ptr_ = other.ptr_;
-    size_in_bytes_ = other.size_in_bytes_;
-    work_type_ = other.work_type_;
-    processed_bytes_upto_now_ = other.processed_bytes_upto_now_;
-    set_status(other.status());
-    extra_data_ = other.extra_data_;
-    return *this;
+void WorkRequest::MarkDone() {
+    if (!done_.exchange(true, std::memory_order_acq_rel)) {
+        Unref();
+    }
 }
 
 WorkStatus WorkRequest::status() const {
@@ -52,21 +59,66 @@ WorkStatus WorkRequest::status() const {
 
 void WorkRequest::set_status(const WorkStatus& status) {
     status_.store(status, std::memory_order_release);
+    if (IsDone(status)) {
+        WorkRequestManager::Get()->NotifyDone();
+        // still holding the slot, so callbacks may delete the completion
+        RunDoneCallbacks(status);
+        MarkDone();
+    }
     return;
 }
 
-bool WorkRequest::AddBytes(const size_t nbytes) {
+bool WorkRequest::AddBytes(const size_t nbytes, const bool& finish) {
     processed_bytes_upto_now_ += nbytes;
     if (processed_bytes_upto_now_ == size_in_bytes_) {
-        status_ = WorkStatus::kFinished;
+        if (!finish) {
+            return true;
+        }
+        // the slot is kept until the channel sets the final status itself,
+        // so a late set_status by id can not hit the next request
+        status_.store(WorkStatus::kFinished, std::memory_order_release);
         return true;
     }
     return false;
 }
 
+void WorkRequest::StartIfDeferred() {
+    if (wait_callback_ &&
+        status_.load(std::memory_order_acquire) == WorkStatus::kPending) {
+        wait_callback_();
+    }
+}
+
+void WorkRequest::AddDoneCallback(
+    const std::function<void(const WorkStatus&)>& callback) {
+    {
+        std::lock_guard<utils::SpinLock> lg(callback_lock_);
+        if (!callbacks_run_) {
+            done_callbacks_.emplace_back(callback);
+            return;
+        }
+    }
+    callback(status());
+}
+
+void WorkRequest::RunDoneCallbacks(const WorkStatus& status) {
+    std::vector<std::function<void(const WorkStatus&)>> callbacks;
+    {
+        std::lock_guard<utils::SpinLock> lg(callback_lock_);
+        if (callbacks_run_) {
+            return;
+        }
+        callbacks_run_ = true;
+        callbacks.swap(done_callbacks_);
+    }
+    for (auto& callback : callbacks) {
+        callback(status);
+    }
+}
+
 void WorkRequest::Wait() {
-    if ((status_.load(std::memory_order_acquire) != WorkStatus::kFinished) &&
-           (status_.load(std::memory_order_acquire) != WorkStatus::kError)) {
+    StartIfDeferred();
+    while (!IsDone(status_.load(std::memory_order_acquire))) {
         sema_.Wait();
     }
 }
@@ -99,87 +151,174 @@ void* WorkRequest::ptr() {
     return ptr_;
 }
 
-WorkRequestManager::WorkRequestManager() {
-    store_lock_ = utils::make_unique<utils::SpinLock>();
-    id_lock_ = utils::make_unique<utils::SpinLock>();
-    cur_req_id_ = 0;
+WorkRequestManager::WorkRequestManager(const uint32_t& capacity)
+    : capacity_((capacity + kChunkSize - 1) / kChunkSize * kChunkSize),
+      chunks_(new std::atomic<WorkRequest*>[capacity_ / kChunkSize]),
+      num_slots_(0),
+      free_head_(kNilIndex),
+      done_epoch_(0),
+      num_set_waiters_(0) {
+    for (uint32_t i = 0; i < capacity_ / kChunkSize; i++) {
+        chunks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+WorkRequestManager::~WorkRequestManager() {
+    for (uint32_t i = 0; i < capacity_ / kChunkSize; i++) {
+        delete[] chunks_[i].load(std::memory_order_relaxed);
+    }
 }
 
 WorkRequestManager* WorkRequestManager::Get() {
-    static WorkRequestManager mgr;
+    static WorkRequestManager mgr(Env::Get()->GetEnv(
+        "RDC_MAX_WORK_REQUESTS", kDefaultWorkRequestCapacity));
     return &mgr;
 }
 
-void WorkRequestManager::AddWorkRequest(const WorkRequest& req) {
-    store_lock_->lock();
-    // note: a work request copy will be triggered here
-    all_work_reqs[req.id()] = req;
-    store_lock_->unlock();
+uint32_t WorkRequestManager::AllocSlot() {
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head) != kNilIndex) {
+        const auto& index = static_cast<uint32_t>(head);
+        // the slot stays allocated even if someone else pops it meanwhile,
+        // and then the tag makes the exchange fail
+        const uint64_t next =
+            ((head >> 32) + 1) << 32 |
+            Slot(index).next_free_.load(std::memory_order_relaxed);
+        if (free_head_.compare_exchange_weak(head, next,
+                                             std::memory_order_acq_rel)) {
+            return index;
+        }
+    }
+    const auto& index = num_slots_.fetch_add(1, std::memory_order_relaxed);
+    CHECK_F(index < capacity_,
+            "more than %u work requests outstanding, are work completions "
+            "deleted? raise RDC_MAX_WORK_REQUESTS otherwise",
+            capacity_);
+    auto& chunk = chunks_[index / kChunkSize];
+    if (chunk.load(std::memory_order_acquire) == nullptr) {
+        std::lock_guard<std::mutex> lg(chunk_lock_);
+        if (chunk.load(std::memory_order_relaxed) == nullptr) {
+            chunk.store(new WorkRequest[kChunkSize], std::memory_order_release);
+        }
+    }
+    return index;
+}
+
+void WorkRequestManager::FreeSlot(const uint32_t& index) {
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+    do {
+        Slot(index).next_free_.store(static_cast<uint32_t>(head),
+                                     std::memory_order_relaxed);
+    } while (!free_head_.compare_exchange_weak(
+        head, (head >> 32) << 32 | index, std::memory_order_acq_rel));
+}
+
+void WorkRequestManager::NotifyDone() {
+    // pairs with the increment in WaitUntil, either we see the waiter or it
+    // sees the status stored before
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_set_waiters_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lg(done_lock_);
+        done_epoch_++;
+    }
+    done_cond_.notify_all();
+}
+
+void WorkRequestManager::WaitUntil(const std::function<bool()>& pred) {
+    num_set_waiters_.fetch_add(1, std::memory_order_seq_cst);
+    std::unique_lock<std::mutex> lock(done_lock_);
+    while (!pred()) {
+        const auto epoch = done_epoch_;
+        done_cond_.wait(lock, [this, epoch] { return done_epoch_ != epoch; });
+    }
+    lock.unlock();
+    num_set_waiters_.fetch_sub(1, std::memory_order_relaxed);
 }
 
 uint64_t WorkRequestManager::NewWorkRequest(const WorkType& work_type,
                                             void* ptr, const size_t& size) {
-    id_lock_->lock();
-    cur_req_id_++;
-    WorkRequest work_req(cur_req_id_, work_type, ptr, size);
-    id_lock_->unlock();
-    AddWorkRequest(work_req);
+    const auto& index = AllocSlot();
+    auto& work_req = Slot(index);
+    // generations start from 1, so that no id is 0
+    const uint64_t generation = (work_req.req_id_ >> 32) + 1;
+    work_req.Reset(generation << 32 | index, work_type, ptr, size);
     return work_req.id();
 }
 
 uint64_t WorkRequestManager::NewWorkRequest(const WorkType& work_type,
                                             const void* ptr,
                                             const size_t& size) {
-    id_lock_->lock();
-    cur_req_id_++;
-    WorkRequest work_req(cur_req_id_, work_type, ptr, size);
-    id_lock_->unlock();
-    AddWorkRequest(work_req);
-    return work_req.id();
+    return NewWorkRequest(work_type, const_cast<void*>(ptr), size);
 }
 
 WorkRequest& WorkRequestManager::GetWorkRequest(const uint64_t& req_id) {
-    std::lock_guard<utils::SpinLock> lg(*store_lock_);
-    return all_work_reqs[req_id];
+    return Slot(static_cast<uint32_t>(req_id));
 }
 
 bool WorkRequestManager::AddBytes(const uint64_t& req_id, size_t nbytes) {
-    return all_work_reqs[req_id].AddBytes(nbytes);
+    return GetWorkRequest(req_id).AddBytes(nbytes);
 }
 
 bool WorkRequestManager::Contain(const uint64_t& req_id) {
-    return all_work_reqs.count(req_id);
+    const auto& index = static_cast<uint32_t>(req_id);
+    if (index >= std::min(num_slots_.load(std::memory_order_acquire),
+                          capacity_) ||
+        chunks_[index / kChunkSize].load(std::memory_order_acquire) ==
+            nullptr) {
+        return false;
+    }
+    return Slot(index).id() == req_id;
 }
 
 void WorkRequestManager::Wait(const uint64_t& req_id) {
-    store_lock_->lock();
-    auto& work_req = all_work_reqs[req_id];
-    store_lock_->unlock();
-    work_req.Wait();
+    GetWorkRequest(req_id).Wait();
 }
 
 size_t WorkRequestManager::processed_bytes_upto_now(const uint64_t& req_id) {
-    return all_work_reqs[req_id].processed_bytes_upto_now();
+    return GetWorkRequest(req_id).processed_bytes_upto_now();
 }
 
 WorkStatus WorkRequestManager::status(const uint64_t& req_id) {
-    return all_work_reqs[req_id].status();
+    return GetWorkRequest(req_id).status();
 }
 
 void WorkRequestManager::set_status(const uint64_t& req_id,
                                     const WorkStatus& status) {
-    all_work_reqs[req_id].set_status(status);
+    if (Contain(req_id)) {
+        GetWorkRequest(req_id).set_status(status);
+    }
+}
+
+void WorkRequestManager::Release(const uint64_t& req_id) {
+    if (Contain(req_id)) {
+        GetWorkRequest(req_id).Unref();
+    }
 }
 
 WorkCompletion::WorkCompletion(const uint64_t& id)
     : id_(id), processed_bytes_upto_now_(0) {
 }
 
+WorkCompletion::~WorkCompletion() {
+    WorkRequestManager::Get()->Release(id_);
+}
+
+uint64_t WorkCompletion::WorkRequstId() const {
+    return id_;
+}
+
 void WorkCompletion::Wait() {
     CHECK(WorkRequestManager::Get()->Contain(id_));
     WorkRequestManager::Get()->Wait(id_);
 }
 
+bool WorkCompletion::Test() {
+    return IsDone(status());
+}
+
 WorkStatus WorkCompletion::status() {
     // only query once
     if (WorkRequestManager::Get()->Contain(id_)) {
@@ -188,20 +327,92 @@ WorkStatus WorkCompletion::status() {
     return status_;
 }
 
+size_t WorkCompletion::WaitAny(const std::vector<WorkCompletion*>& work_comps) {
+    return WaitSome(work_comps).front();
+}
+
+std::vector<size_t> WorkCompletion::WaitSome(
+    const std::vector<WorkCompletion*>& work_comps) {
+    CHECK_F(!work_comps.empty(), "waiting on an empty set");
+    for (auto& work_comp : work_comps) {
+        WorkRequestManager::Get()
+            ->GetWorkRequest(work_comp->WorkRequstId())
+            .StartIfDeferred();
+    }
+    std::vector<size_t> done_indices;
+    WorkRequestManager::Get()->WaitUntil([&work_comps, &done_indices] {
+        for (auto i = 0U; i < work_comps.size(); i++) {
+            if (work_comps[i]->Test()) {
+                done_indices.emplace_back(i);
+            }
+        }
+        return !done_indices.empty();
+    });
+    return done_indices;
+}
+
+void WorkCompletion::WaitAll(const std::vector<WorkCompletion*>& work_comps) {
+    for (auto& work_comp : work_comps) {
+        work_comp->Wait();
+    }
+}
+
+void WorkCompletion::OnDone(
+    const std::function<void(const WorkStatus&)>& callback) {
+    CHECK(WorkRequestManager::Get()->Contain(id_));
+    auto& work_req = WorkRequestManager::Get()->GetWorkRequest(id_);
+    work_req.AddDoneCallback(callback);
+    work_req.StartIfDeferred();
+}
+
+WorkCompletion* WorkCompletion::Then(
+    const std::function<WorkCompletion*()>& next) {
+    const uint64_t then_id = WorkRequestManager::Get()->NewWorkRequest(
+        WorkType::kCollective, static_cast<void*>(nullptr), 0);
+    auto then_wc = WorkCompletion::New(then_id);
+    // the request of then_wc is kept until it gets a final status here
+    auto finish = [then_id](const WorkStatus& status) {
+        auto& work_req = WorkRequestManager::Get()->GetWorkRequest(then_id);
+        work_req.set_status(status);
+        work_req.Notify();
+    };
+    OnDone([next, finish](const WorkStatus& status) {
+        if (status != WorkStatus::kFinished) {
+            return finish(status);
+        }
+        auto next_wc = next();
+        if (next_wc == nullptr) {
+            return finish(WorkStatus::kFinished);
+        }
+        next_wc->OnDone([next_wc, finish](const WorkStatus& status) {
+            finish(status);
+            WorkCompletion::Delete(next_wc);
+        });
+    });
+    return then_wc;
+}
+
 ChainWorkCompletion::~ChainWorkCompletion() {
     for (auto& work_comp : this->work_comps_) {
         WorkCompletion::Delete(work_comp);
     }
 }
 
-void ChainWorkCompletion::Push(WorkCompletion* work_comp) {
+void ChainWorkCompletion::Add(WorkCompletion* work_comp) {
     work_comps_.emplace_back(work_comp);
 }
 
-void ChainWorkCompletion::Wait() {
+bool ChainWorkCompletion::Test() {
     for (auto& work_comp : work_comps_) {
-        work_comp->Wait();
+        if (!work_comp->Test()) {
+            return false;
+        }
     }
+    return true;
+}
+
+void ChainWorkCompletion::Wait() {
+    WorkCompletion::WaitAll(work_comps_);
 }
 
 WorkStatus ChainWorkCompletion::status() {
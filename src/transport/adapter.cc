@@ -3,6 +3,9 @@
 #ifdef RDC_USE_RDMA
 #include "transport/rdma/rdma_adapter.h"
 #endif
+#ifdef RDC_USE_IO_URING
+#include "transport/io_uring/io_uring_adapter.h"
+#endif
 #include "common/env.h"
 #include "utils/utils.h"
 
@@ -30,6 +33,8 @@ std::tuple<Backend, std::string, uint32_t> ParseAddr(
         backend = kRdma;
     } else if (backend_str == "ipc") {
         backend = kIpc;
+    } else if (backend_str == "io_uring") {
+        backend = kIoUring;
     } else {
         backend = kTcp;
     }
@@ -44,6 +49,8 @@ std::string GetBackendString(const Backend& backend) {
         backend_str = "rdma";
     } else if (backend == kIpc) {
         backend_str = "ipc";
+    } else if (backend == kIoUring) {
+        backend_str = "io_uring";
     } else {
         backend_str = "tcp";
     }
@@ -61,6 +68,11 @@ IAdapter* GetAdapter() {
     if (std::strncmp(backend, "RDMA", 4) == 0) {
         return RdmaAdapter::Get();
     }
+#endif
+#ifdef RDC_USE_IO_URING
+    if (std::strncmp(backend, "IO_URING", 8) == 0) {
+        return IoUringAdapter::Get();
+    }
 #endif
     return nullptr;
 }
@@ -25,6 +25,25 @@ bool IChannel::Connect(const std::string& addr_str) {
     return Connect(host, port);
 }
 
+WorkCompletion* IChannel::ISend(Buffer sendbuf, const int32_t& tag) {
+    CHECK_F(tag == kDefaultTag, "tag %d needs a framed channel", tag);
+    return this->ISend(sendbuf);
+}
+
+WorkCompletion* IChannel::IRecv(Buffer recvbuf, const int32_t& tag) {
+    CHECK_F(tag == kDefaultTag || tag == kAnyTag,
+            "tag %d needs a framed channel", tag);
+    return this->IRecv(recvbuf);
+}
+
+ChainWorkCompletion* IChannel::ISendv(const std::vector<Buffer>& sendbufs) {
+    auto chain_wc = ChainWorkCompletion::New();
+    for (const auto& sendbuf : sendbufs) {
+        chain_wc->Add(this->ISend(sendbuf));
+    }
+    return chain_wc;
+}
+
 WorkCompletion* IChannel::ISend(const void* sendaddr,
                                 const uint64_t& sendbytes) {
     Buffer sendbuf(sendaddr, sendbytes);
@@ -46,11 +65,9 @@ WorkStatus IChannel::SendInt(int32_t val) {
 
 WorkStatus IChannel::SendStr(std::string str) {
     int32_t size = static_cast<int32_t>(str.size());
-    auto chain_wc = ChainWorkCompletion::New();
-    auto wc = this->ISend(&size, sizeof(size));
-    chain_wc->Add(wc);
-    wc = this->ISend(utils::BeginPtr(str), str.size());
-    chain_wc->Add(wc);
+    // the length and the bytes go out together
+    auto chain_wc = this->ISendv({Buffer(&size, sizeof(size)),
+                                  Buffer(utils::BeginPtr(str), str.size())});
     chain_wc->Wait();
     auto status = chain_wc->status();
     ChainWorkCompletion::Delete(chain_wc);
@@ -58,11 +75,8 @@ WorkStatus IChannel::SendStr(std::string str) {
 }
 
 WorkStatus IChannel::SendBytes(void* ptr, const int32_t& sendbytes) {
-    auto chain_wc = ChainWorkCompletion::New();
-    auto wc = this->ISend(&sendbytes, sizeof(sendbytes));
-    chain_wc->Add(wc);
-    wc = this->ISend(ptr, sendbytes);
-    chain_wc->Add(wc);
+    auto chain_wc = this->ISendv(
+        {Buffer(&sendbytes, sizeof(sendbytes)), Buffer(ptr, sendbytes)});
     chain_wc->Wait();
     auto status = chain_wc->status();
     ChainWorkCompletion::Delete(chain_wc);
@@ -88,6 +102,7 @@ WorkStatus IChannel::RecvStr(std::string& str) {
     }
     str.resize(size);
     wc = this->IRecv(utils::BeginPtr(str), str.size());
+    wc->Wait();
     status = wc->status();
     WorkCompletion::Delete(wc);
     return status;
@@ -102,6 +117,7 @@ WorkStatus IChannel::RecvBytes(void* ptr, int32_t& recvbytes) {
         return status;
     }
     wc = this->IRecv(ptr, recvbytes);
+    wc->Wait();
     status = wc->status();
     WorkCompletion::Delete(wc);
     return status;
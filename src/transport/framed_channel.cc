@@ -0,0 +1,454 @@
+#include "transport/framed_channel.h"
+#include <cstring>
+#include <vector>
+#include "core/logging.h"
+
+namespace rdc {
+namespace {
+const uint32_t kFrameMagic = 0x52444346;  // "RDCF"
+// an eager frame has to fit the 16KB default arena of the bounce pool
+const uint64_t kMaxEagerLimit = 15 << 10;
+
+/*! @brief stable over processes, unlike std::hash */
+uint32_t HashCommName(const std::string& name) {
+    uint32_t hash = 2166136261U;
+    for (const auto& c : name) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619U;
+    }
+    return hash;
+}
+
+void FinishRequest(const uint64_t& req_id, const WorkStatus& status) {
+    auto& work_req = WorkRequestManager::Get()->GetWorkRequest(req_id);
+    work_req.set_status(status);
+    work_req.Notify();
+}
+}  // namespace
+
+FramedChannel::FramedChannel(const std::shared_ptr<IChannel>& stream,
+                             const uint64_t& eager_limit)
+    : IChannel(ChannelKind::kReadWrite),
+      stream_(stream),
+      comm_id_(HashCommName(stream->comm())),
+      eager_limit_(eager_limit),
+      bounce_pool_(std::make_shared<Pool>()) {
+    CHECK_F(eager_limit_ <= kMaxEagerLimit,
+            "eager limit %lu is above %lu bytes", eager_limit_,
+            kMaxEagerLimit);
+    this->set_comm(stream_->comm());
+    this->set_peer_rank(stream_->peer_rank());
+    this->Pump();
+}
+
+FramedChannel::~FramedChannel() {
+    if (!closing_.load(std::memory_order_acquire)) {
+        this->Close();
+    }
+}
+
+bool FramedChannel::Connect(const std::string& hostname,
+                            const uint32_t& port) {
+    return stream_->Connect(hostname, port);
+}
+
+uint64_t FramedChannel::max_eager_limit() {
+    return kMaxEagerLimit;
+}
+
+WorkCompletion* FramedChannel::ISend(Buffer sendbuf, const int32_t& tag) {
+    const uint64_t req_id = WorkRequestManager::Get()->NewWorkRequest(
+        WorkType::kSend, sendbuf.addr(), sendbuf.size_in_bytes());
+    auto wc = WorkCompletion::New(req_id);
+    std::unique_lock<std::mutex> lock(send_lock_);
+    WorkStatus status = WorkStatus::kFinished;
+    if (closing_.load(std::memory_order_acquire)) {
+        status = WorkStatus::kClosed;
+    } else if (this->error_detected()) {
+        status = WorkStatus::kError;
+    } else if (sendbuf.size_in_bytes() < eager_limit_) {
+        SendFrame(FrameType::kEager, tag, sendbuf.size_in_bytes(), 0,
+                  sendbuf.addr());
+    } else {
+        // done once the payload is sent after the cts
+        const uint64_t seq = next_seq_++;
+        pending_sends_[seq] = {sendbuf, req_id};
+        SendFrame(FrameType::kRts, tag, sendbuf.size_in_bytes(), seq,
+                  nullptr);
+        return wc;
+    }
+    // the payload of an eager send is copied, the buffer is free again
+    lock.unlock();
+    FinishRequest(req_id, status);
+    return wc;
+}
+
+WorkCompletion* FramedChannel::IRecv(Buffer recvbuf, const int32_t& tag) {
+    const uint64_t req_id = WorkRequestManager::Get()->NewWorkRequest(
+        WorkType::kRecv, recvbuf.addr(), recvbuf.size_in_bytes());
+    auto wc = WorkCompletion::New(req_id);
+    std::unique_lock<std::mutex> lock(match_lock_);
+    if (closing_.load(std::memory_order_acquire)) {
+        lock.unlock();
+        FinishRequest(req_id, WorkStatus::kClosed);
+        return wc;
+    }
+    // messages which arrived before the stream broke are still delivered
+    for (auto it = unexpected_.begin(); it != unexpected_.end(); ++it) {
+        auto message = *it;
+        if (message->matched || !TagMatches(tag, message->header.tag)) {
+            continue;
+        }
+        if (message->header.type == FrameType::kRts) {
+            unexpected_.erase(it);
+            if (message->header.length > recvbuf.size_in_bytes()) {
+                lock.unlock();
+                LOG_F(ERROR, "message of %lu bytes overflows receive of %lu",
+                      message->header.length, recvbuf.size_in_bytes());
+                FinishRequest(req_id, WorkStatus::kError);
+                return wc;
+            }
+            awaiting_data_[message->header.seq] = {tag, recvbuf, req_id};
+            lock.unlock();
+            SendCts(message->header);
+        } else if (message->arrived) {
+            unexpected_.erase(it);
+            lock.unlock();
+            Deliver(*message, recvbuf, req_id);
+        } else {
+            // delivered by the reader once the payload is in
+            message->matched = true;
+            message->recvbuf = recvbuf;
+            message->req_id = req_id;
+        }
+        return wc;
+    }
+    if (this->error_detected()) {
+        lock.unlock();
+        FinishRequest(req_id, WorkStatus::kError);
+        return wc;
+    }
+    posted_.push_back({tag, recvbuf, req_id});
+    return wc;
+}
+
+void FramedChannel::Close() {
+    closing_.store(true, std::memory_order_release);
+    stream_->Close();
+    FailAll(WorkStatus::kClosed);
+}
+
+void FramedChannel::SendFrame(const FrameType& type, const int32_t& tag,
+                              const uint64_t& length, const uint64_t& seq,
+                              const void* payload) {
+    const size_t nbytes =
+        sizeof(FrameHeader) + (payload != nullptr ? length : 0);
+    auto pool = bounce_pool_;
+    auto frame = static_cast<uint8_t*>(pool->allocate(nbytes));
+    auto header = reinterpret_cast<FrameHeader*>(frame);
+    header->magic = kFrameMagic;
+    header->tag = tag;
+    header->comm_id = comm_id_;
+    header->type = type;
+    header->length = length;
+    header->seq = seq;
+    if (payload != nullptr && length != 0) {
+        std::memcpy(frame + sizeof(FrameHeader), payload, length);
+    }
+    // the receiver reads the header alone, and a striped stream cuts a
+    // message by the size of its send, so the payload is a send of its own
+    auto frame_wc = stream_->ISend(frame, sizeof(FrameHeader));
+    if (payload != nullptr) {
+        frame_wc->OnDone([frame_wc](const WorkStatus&) {
+            WorkCompletion::Delete(frame_wc);
+        });
+        frame_wc = stream_->ISend(frame + sizeof(FrameHeader), length);
+    }
+    // the stream keeps order, the frame is sent once its last part is
+    frame_wc->OnDone([pool, frame, nbytes, frame_wc](const WorkStatus&) {
+        pool->deallocate(frame, nbytes);
+        WorkCompletion::Delete(frame_wc);
+    });
+}
+
+void FramedChannel::SendCts(const FrameHeader& rts) {
+    std::lock_guard<std::mutex> lg(send_lock_);
+    if (closing_.load(std::memory_order_acquire)) {
+        return;
+    }
+    SendFrame(FrameType::kCts, rts.tag, rts.length, rts.seq, nullptr);
+}
+
+bool FramedChannel::SendData(const uint64_t& seq) {
+    WorkCompletion* data_wc = nullptr;
+    uint64_t req_id = 0;
+    {
+        std::lock_guard<std::mutex> lg(send_lock_);
+        auto it = pending_sends_.find(seq);
+        if (it == pending_sends_.end()) {
+            LOG_F(ERROR, "cts from %d for unknown message %lu", peer_rank(),
+                  seq);
+            return false;
+        }
+        auto sendbuf = it->second.sendbuf;
+        req_id = it->second.req_id;
+        pending_sends_.erase(it);
+        SendFrame(FrameType::kData, header_.tag, sendbuf.size_in_bytes(), seq,
+                  nullptr);
+        data_wc = stream_->ISend(sendbuf);
+    }
+    // outside of the lock, done callbacks may send again
+    data_wc->OnDone([req_id, data_wc](const WorkStatus& status) {
+        WorkCompletion::Delete(data_wc);
+        FinishRequest(req_id, status);
+    });
+    return true;
+}
+
+void FramedChannel::Pump() {
+    while (true) {
+        auto wc = PostRead();
+        if (wc == nullptr) {
+            return;
+        }
+        if (!wc->Test()) {
+            // a read which completes meanwhile runs the callback right here
+            wc->OnDone([this, wc](const WorkStatus& status) {
+                WorkCompletion::Delete(wc);
+                if (Advance(status)) {
+                    Pump();
+                }
+            });
+            return;
+        }
+        const auto status = wc->status();
+        WorkCompletion::Delete(wc);
+        if (!Advance(status)) {
+            return;
+        }
+    }
+}
+
+WorkCompletion* FramedChannel::PostRead() {
+    if (closing_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    if (!reading_payload_) {
+        return stream_->IRecv(&header_, sizeof(header_));
+    }
+    if (cur_unexpected_) {
+        return stream_->IRecv(cur_unexpected_->payload, header_.length);
+    }
+    return stream_->IRecv(cur_recvbuf_.Slice(0, header_.length));
+}
+
+bool FramedChannel::Advance(const WorkStatus& status) {
+    if (status != WorkStatus::kFinished ||
+        closing_.load(std::memory_order_acquire)) {
+        if (!closing_.load(std::memory_order_acquire)) {
+            this->set_error_detected(true);
+        }
+        FailAll(closing_.load(std::memory_order_acquire) ? WorkStatus::kClosed
+                                                         : status);
+        return false;
+    }
+    if (reading_payload_) {
+        FinishPayload();
+        return true;
+    }
+    if (!HandleHeader()) {
+        this->set_error_detected(true);
+        FailAll(WorkStatus::kError);
+        return false;
+    }
+    if (reading_payload_ && header_.length == 0) {
+        FinishPayload();
+    }
+    return true;
+}
+
+bool FramedChannel::HandleHeader() {
+    if (header_.magic != kFrameMagic) {
+        LOG_F(ERROR, "malformed frame from %d in %s", peer_rank(),
+              comm().c_str());
+        return false;
+    }
+    if (header_.comm_id != comm_id_) {
+        LOG_F(ERROR, "frame from %d for another communicator than %s",
+              peer_rank(), comm().c_str());
+        return false;
+    }
+    cur_unexpected_.reset();
+    switch (header_.type) {
+        case FrameType::kEager:
+            return MatchEager();
+        case FrameType::kRts:
+            return MatchRts();
+        case FrameType::kCts:
+            return SendData(header_.seq);
+        case FrameType::kData:
+            return MatchData();
+    }
+    LOG_F(ERROR, "frame of unknown type %u from %d",
+          static_cast<uint32_t>(header_.type), peer_rank());
+    return false;
+}
+
+bool FramedChannel::MatchEager() {
+    reading_payload_ = true;
+    std::lock_guard<std::mutex> lg(match_lock_);
+    for (auto it = posted_.begin(); it != posted_.end(); ++it) {
+        if (!TagMatches(it->tag, header_.tag)) {
+            continue;
+        }
+        if (header_.length > it->recvbuf.size_in_bytes()) {
+            LOG_F(ERROR,
+                  "message of %lu bytes from %d overflows receive of %lu",
+                  header_.length, peer_rank(), it->recvbuf.size_in_bytes());
+            return false;
+        }
+        cur_posted_ = true;
+        cur_req_id_ = it->req_id;
+        cur_recvbuf_ = it->recvbuf;
+        posted_.erase(it);
+        return true;
+    }
+    cur_unexpected_ = std::make_shared<Unexpected>();
+    cur_unexpected_->header = header_;
+    cur_unexpected_->pool = bounce_pool_;
+    if (header_.length != 0) {
+        cur_unexpected_->payload =
+            static_cast<uint8_t*>(bounce_pool_->allocate(header_.length));
+    }
+    unexpected_.emplace_back(cur_unexpected_);
+    return true;
+}
+
+bool FramedChannel::MatchRts() {
+    {
+        std::lock_guard<std::mutex> lg(match_lock_);
+        auto it = posted_.begin();
+        while (it != posted_.end() && !TagMatches(it->tag, header_.tag)) {
+            ++it;
+        }
+        if (it == posted_.end()) {
+            // answered once a receive for it is posted
+            auto message = std::make_shared<Unexpected>();
+            message->header = header_;
+            message->arrived = true;
+            unexpected_.emplace_back(message);
+            return true;
+        }
+        if (header_.length > it->recvbuf.size_in_bytes()) {
+            LOG_F(ERROR,
+                  "message of %lu bytes from %d overflows receive of %lu",
+                  header_.length, peer_rank(), it->recvbuf.size_in_bytes());
+            return false;
+        }
+        awaiting_data_[header_.seq] = *it;
+        posted_.erase(it);
+    }
+    SendCts(header_);
+    return true;
+}
+
+bool FramedChannel::MatchData() {
+    std::lock_guard<std::mutex> lg(match_lock_);
+    auto it = awaiting_data_.find(header_.seq);
+    if (it == awaiting_data_.end()) {
+        LOG_F(ERROR, "data from %d for unknown message %lu", peer_rank(),
+              header_.seq);
+        return false;
+    }
+    reading_payload_ = true;
+    cur_posted_ = true;
+    cur_req_id_ = it->second.req_id;
+    cur_recvbuf_ = it->second.recvbuf;
+    awaiting_data_.erase(it);
+    return true;
+}
+
+void FramedChannel::FinishPayload() {
+    reading_payload_ = false;
+    if (!cur_unexpected_) {
+        std::unique_lock<std::mutex> lock(match_lock_);
+        // failed by a close meanwhile
+        if (!cur_posted_) {
+            return;
+        }
+        cur_posted_ = false;
+        lock.unlock();
+        FinishRequest(cur_req_id_, WorkStatus::kFinished);
+        return;
+    }
+    auto message = std::move(cur_unexpected_);
+    {
+        std::lock_guard<std::mutex> lg(match_lock_);
+        message->arrived = true;
+        if (!message->matched) {
+            return;
+        }
+        for (auto it = unexpected_.begin(); it != unexpected_.end(); ++it) {
+            if (*it == message) {
+                unexpected_.erase(it);
+                break;
+            }
+        }
+    }
+    Deliver(*message, message->recvbuf, message->req_id);
+}
+
+void FramedChannel::Deliver(const Unexpected& message, Buffer recvbuf,
+                            const uint64_t& req_id) {
+    if (message.header.length > recvbuf.size_in_bytes()) {
+        LOG_F(ERROR, "message of %lu bytes overflows receive of %lu",
+              message.header.length, recvbuf.size_in_bytes());
+        FinishRequest(req_id, WorkStatus::kError);
+        return;
+    }
+    if (message.header.length != 0) {
+        std::memcpy(recvbuf.addr(), message.payload, message.header.length);
+    }
+    FinishRequest(req_id, WorkStatus::kFinished);
+}
+
+void FramedChannel::FailAll(const WorkStatus& status) {
+    std::vector<uint64_t> failed;
+    {
+        std::lock_guard<std::mutex> lg(match_lock_);
+        for (const auto& posted : posted_) {
+            failed.emplace_back(posted.req_id);
+        }
+        posted_.clear();
+        // keep whole eager messages for later receives, a rts can not be
+        // answered anymore and the message being read is dropped
+        for (auto it = unexpected_.begin(); it != unexpected_.end();) {
+            if ((*it)->arrived && (*it)->header.type == FrameType::kEager) {
+                ++it;
+                continue;
+            }
+            if ((*it)->matched) {
+                failed.emplace_back((*it)->req_id);
+            }
+            it = unexpected_.erase(it);
+        }
+        for (const auto& awaiting : awaiting_data_) {
+            failed.emplace_back(awaiting.second.req_id);
+        }
+        awaiting_data_.clear();
+        if (cur_posted_) {
+            failed.emplace_back(cur_req_id_);
+            cur_posted_ = false;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lg(send_lock_);
+        for (const auto& pending : pending_sends_) {
+            failed.emplace_back(pending.second.req_id);
+        }
+        pending_sends_.clear();
+    }
+    for (const auto& req_id : failed) {
+        FinishRequest(req_id, status);
+    }
+}
+}  // namespace rdc
@@ -0,0 +1,225 @@
+#ifdef RDC_USE_IO_URING
+#include "transport/io_uring/io_uring_adapter.h"
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include "common/env.h"
+#include "core/logging.h"
+#include "sys/error.h"
+
+namespace rdc {
+namespace {
+// two submissions per channel at most, so this covers hundreds of peers
+const uint32_t kDefaultRingEntries = 1024;
+const uint32_t kDefaultMaxFixedFiles = 1024;
+// user data of the nop which stops the poller
+const uint64_t kShutdownMarker = 0;
+
+inline int IoUringSetup(const uint32_t& entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+inline int IoUringEnter(const int& fd, const uint32_t& to_submit,
+                        const uint32_t& min_complete, const uint32_t& flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                    min_complete, flags, nullptr, 0));
+}
+
+inline int IoUringRegister(const int& fd, const uint32_t& opcode,
+                           const void* arg, const uint32_t& nr_args) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+}  // namespace
+
+IoUringAdapter::IoUringAdapter() {
+    this->set_backend(kIoUring);
+    SetupRing(Env::Get()->GetEnv("RDC_IO_URING_ENTRIES", kDefaultRingEntries));
+    // a sparse table, slots are filled as channels come and go
+    const uint32_t max_files =
+        Env::Get()->GetEnv("RDC_IO_URING_MAX_FILES", kDefaultMaxFixedFiles);
+    std::vector<int32_t> files(max_files, -1);
+    if (max_files != 0 &&
+        IoUringRegister(ring_fd_, IORING_REGISTER_FILES, files.data(),
+                        max_files) == 0) {
+        for (int32_t i = max_files - 1; i >= 0; i--) {
+            free_files_.emplace_back(i);
+        }
+    } else {
+        LOG_F(WARNING, "io_uring fixed files unavailable, using plain fds");
+    }
+    poll_thrd_.reset(new std::thread([this] { PollForever(); }));
+}
+
+IoUringAdapter::~IoUringAdapter() {
+    {
+        std::lock_guard<std::mutex> lg(submit_lock_);
+        const auto& tail = *sq_tail_;
+        const auto& index = tail & sq_mask_;
+        auto* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = kShutdownMarker;
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        IoUringEnter(ring_fd_, 1, 0, 0);
+    }
+    poll_thrd_->join();
+    munmap(sqes_, sqes_size_);
+    if (cq_ptr_ != sq_ptr_) {
+        munmap(cq_ptr_, cq_size_);
+    }
+    munmap(sq_ptr_, sq_size_);
+    close(ring_fd_);
+    listen_sock_.Close();
+}
+
+void IoUringAdapter::SetupRing(const uint32_t& entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring_fd_ = IoUringSetup(entries, &params);
+    CHECK_F(ring_fd_ >= 0, "io_uring_setup failed: %s",
+            sys::FormatError(errno).c_str());
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    CHECK_F(sq_ptr_ != MAP_FAILED, "failed to map submission ring");
+    cq_ptr_ = sq_ptr_;
+    if (!single_mmap) {
+        cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        CHECK_F(cq_ptr_ != MAP_FAILED, "failed to map completion ring");
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = reinterpret_cast<io_uring_sqe*>(
+        mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+    CHECK_F(sqes_ != MAP_FAILED, "failed to map submission entries");
+    auto* sq = reinterpret_cast<uint8_t*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    sq_array_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+    sq_mask_ = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    auto* cq = reinterpret_cast<uint8_t*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+void IoUringAdapter::Listen(const int& port) {
+    VLOG_F(3, "Listening on port %d ", port);
+    listen_sock_.TryBindHost(port);
+    listen_sock_.SetReuseAddr(true);
+    listen_sock_.Listen(kNumBacklogs);
+}
+
+IChannel* IoUringAdapter::Accept() {
+    const auto& sock = listen_sock_.Accept();
+    return new IoUringChannel(this, sock);
+}
+
+int32_t IoUringAdapter::AddChannel(IoUringChannel* channel) {
+    std::lock_guard<std::mutex> lg(files_lock_);
+    if (free_files_.empty()) {
+        return -1;
+    }
+    int32_t fd = channel->sockfd();
+    io_uring_files_update update;
+    std::memset(&update, 0, sizeof(update));
+    update.offset = free_files_.back();
+    update.fds = reinterpret_cast<uint64_t>(&fd);
+    if (IoUringRegister(ring_fd_, IORING_REGISTER_FILES_UPDATE, &update, 1) !=
+        1) {
+        return -1;
+    }
+    free_files_.pop_back();
+    return update.offset;
+}
+
+void IoUringAdapter::RemoveChannel(IoUringChannel* channel) {
+    if (channel->file_index() < 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lg(files_lock_);
+    int32_t fd = -1;
+    io_uring_files_update update;
+    std::memset(&update, 0, sizeof(update));
+    update.offset = channel->file_index();
+    update.fds = reinterpret_cast<uint64_t>(&fd);
+    IoUringRegister(ring_fd_, IORING_REGISTER_FILES_UPDATE, &update, 1);
+    free_files_.emplace_back(channel->file_index());
+}
+
+void IoUringAdapter::Submit(IoUringChannel* channel, const bool& is_recv,
+                            void* addr, const uint32_t& len) {
+    std::lock_guard<std::mutex> lg(submit_lock_);
+    const auto& tail = *sq_tail_;
+    // the kernel consumes every entry while we enter, so one is always free
+    CHECK_F(tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) < sq_entries_,
+            "io_uring submission ring is full");
+    const auto& index = tail & sq_mask_;
+    auto* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = is_recv ? IORING_OP_RECV : IORING_OP_SEND;
+    if (channel->file_index() >= 0) {
+        sqe->fd = channel->file_index();
+        sqe->flags = IOSQE_FIXED_FILE;
+    } else {
+        sqe->fd = channel->sockfd();
+    }
+    sqe->addr = reinterpret_cast<uint64_t>(addr);
+    sqe->len = len;
+    sqe->msg_flags = is_recv ? MSG_WAITALL : MSG_NOSIGNAL;
+    // channels are aligned, the lowest bit tells the direction
+    sqe->user_data = reinterpret_cast<uint64_t>(channel) | (is_recv ? 1 : 0);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    int ret = 0;
+    do {
+        ret = IoUringEnter(ring_fd_, 1, 0, 0);
+    } while (ret < 0 && (errno == EINTR || errno == EAGAIN));
+    CHECK_F(ret == 1, "io_uring_enter failed: %s",
+            sys::FormatError(errno).c_str());
+}
+
+void IoUringAdapter::PollForever() {
+    logging::set_thread_name("uringpoller");
+    do {
+        // sleep until at least one completion is there, then take them all
+        if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+            errno != EINTR) {
+            LOG_F(ERROR, "io_uring_enter failed: %s",
+                  sys::FormatError(errno).c_str());
+        }
+    } while (Harvest());
+}
+
+bool IoUringAdapter::Harvest() {
+    auto head = *cq_head_;
+    const auto& tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    bool running = true;
+    for (; head != tail; head++) {
+        const auto& cqe = cqes_[head & cq_mask_];
+        if (cqe.user_data == kShutdownMarker) {
+            running = false;
+            continue;
+        }
+        auto* channel = reinterpret_cast<IoUringChannel*>(cqe.user_data &
+                                                          ~uint64_t(1));
+        channel->OnCompletion(cqe.user_data & 1, cqe.res);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return running;
+}
+}  // namespace rdc
+#endif
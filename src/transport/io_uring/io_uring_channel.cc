@@ -0,0 +1,174 @@
+#ifdef RDC_USE_IO_URING
+#include "transport/io_uring/io_uring_channel.h"
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+#include <vector>
+#include "core/logging.h"
+#include "rdc.h"
+#include "sys/error.h"
+#include "transport/io_uring/io_uring_adapter.h"
+
+namespace rdc {
+namespace {
+// a completion reports the bytes moved as an int32, larger requests go out
+// in several submissions
+const size_t kMaxChunk = 1U << 30;
+}  // namespace
+IoUringChannel::IoUringChannel() {
+    this->adapter_ = nullptr;
+    this->file_index_ = -1;
+    this->sock_ = TcpSocket();
+    this->set_kind(ChannelKind::kReadWrite);
+    this->set_error_detected(false);
+}
+
+IoUringChannel::IoUringChannel(IoUringAdapter* adapter,
+                               const TcpSocket& sock) {
+    this->adapter_ = adapter;
+    this->sock_ = sock;
+    this->set_kind(ChannelKind::kReadWrite);
+    this->set_error_detected(false);
+    this->file_index_ = adapter_->AddChannel(this);
+}
+
+IoUringChannel::~IoUringChannel() {
+    if (!closing_.load(std::memory_order_acquire)) {
+        this->Close();
+    }
+}
+
+bool IoUringChannel::Connect(const std::string& hostname,
+                             const uint32_t& port) {
+    VLOG_F(2, "Trying to connect to process on host %s and port %d",
+           hostname.c_str(), port);
+    if (!sock_.Connect(hostname, port)) {
+        return false;
+    }
+    if (this->adapter_ == nullptr) {
+        this->adapter_ = IoUringAdapter::Get();
+        this->file_index_ = adapter_->AddChannel(this);
+    }
+    return true;
+}
+
+WorkCompletion* IoUringChannel::ISend(Buffer sendbuf) {
+    uint64_t send_req_id = WorkRequestManager::Get()->NewWorkRequest(
+        WorkType::kSend, sendbuf.addr(), sendbuf.size_in_bytes());
+    auto wc = WorkCompletion::New(send_req_id);
+    Enqueue(false, send_req_id);
+    return wc;
+}
+
+WorkCompletion* IoUringChannel::IRecv(Buffer recvbuf) {
+    uint64_t recv_req_id = WorkRequestManager::Get()->NewWorkRequest(
+        WorkType::kRecv, recvbuf.addr(), recvbuf.size_in_bytes());
+    auto wc = WorkCompletion::New(recv_req_id);
+    Enqueue(true, recv_req_id);
+    return wc;
+}
+
+void IoUringChannel::Enqueue(const bool& is_recv, const uint64_t& req_id) {
+    auto& work_req = WorkRequestManager::Get()->GetWorkRequest(req_id);
+    WorkStatus status = WorkStatus::kPending;
+    if (closing_.load(std::memory_order_acquire)) {
+        status = WorkStatus::kClosed;
+    } else if (this->error_detected()) {
+        status = WorkStatus::kError;
+    } else if (work_req.size_in_bytes() == 0) {
+        work_req.AddBytes(0);
+        status = WorkStatus::kFinished;
+    } else {
+        auto& dir = direction(is_recv);
+        std::lock_guard<std::mutex> lg(dir.lock);
+        dir.reqs.push_back(req_id);
+        if (!dir.posted) {
+            PostHead(is_recv);
+        }
+        return;
+    }
+    WorkRequestManager::Get()->set_status(req_id, status);
+    work_req.Notify();
+}
+
+void IoUringChannel::PostHead(const bool& is_recv) {
+    auto& dir = direction(is_recv);
+    auto& work_req = WorkRequestManager::Get()->GetWorkRequest(dir.reqs.front());
+    dir.posted = true;
+    inflight_.fetch_add(1, std::memory_order_acq_rel);
+    adapter_->Submit(
+        this, is_recv,
+        work_req.pointer_at<uint8_t>(work_req.processed_bytes_upto_now()),
+        static_cast<uint32_t>(
+            std::min<size_t>(work_req.remain_nbytes(), kMaxChunk)));
+}
+
+void IoUringChannel::OnCompletion(const bool& is_recv, const int32_t& res) {
+    auto& dir = direction(is_recv);
+    // statuses are set after unlocking, done callbacks may post more work
+    std::vector<uint64_t> done_reqs;
+    WorkStatus done_status = WorkStatus::kFinished;
+    {
+        std::lock_guard<std::mutex> lg(dir.lock);
+        // the kernel cancels what a thread submitted once that thread exits,
+        // like the connecting pool, submit it again from the poller
+        if (res == -EINTR || res == -EAGAIN ||
+            (res == -ECANCELED && !closing_.load(std::memory_order_acquire))) {
+            PostHead(is_recv);
+        } else if (res <= 0 || closing_.load(std::memory_order_acquire)) {
+            if (closing_.load(std::memory_order_acquire)) {
+                done_status = WorkStatus::kClosed;
+            } else {
+                this->set_error_detected(true);
+                done_status = WorkStatus::kError;
+                LOG_F(ERROR, "%s on channel to %d failed: %s",
+                      is_recv ? "receive" : "send", peer_rank(),
+                      res == 0 ? "closed by peer"
+                               : sys::FormatError(-res).c_str());
+            }
+            done_reqs.assign(dir.reqs.begin(), dir.reqs.end());
+            dir.reqs.clear();
+            dir.posted = false;
+        } else {
+            auto& work_req =
+                WorkRequestManager::Get()->GetWorkRequest(dir.reqs.front());
+            if (work_req.AddBytes(res)) {
+                done_reqs.emplace_back(dir.reqs.front());
+                dir.reqs.pop_front();
+                dir.posted = false;
+                if (!dir.reqs.empty()) {
+                    PostHead(is_recv);
+                }
+            } else {
+                // a short transfer, submit what is left
+                PostHead(is_recv);
+            }
+        }
+    }
+    inflight_.fetch_sub(1, std::memory_order_acq_rel);
+    for (const auto& req_id : done_reqs) {
+        auto& work_req = WorkRequestManager::Get()->GetWorkRequest(req_id);
+        WorkRequestManager::Get()->set_status(req_id, done_status);
+        work_req.Notify();
+    }
+}
+
+void IoUringChannel::Close() {
+    closing_.store(true, std::memory_order_release);
+    if (!sock_.IsClosed()) {
+        // fails submissions still in flight, the poller reports them closed
+        shutdown(sock_.sockfd, SHUT_RDWR);
+        while (inflight_.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+        if (this->adapter_) {
+            adapter_->RemoveChannel(this);
+        }
+        sock_.Close();
+    }
+    LOG_F(INFO, "channel with parent communicator %s from %d to %d is closed",
+          comm().c_str(), GetRank(), peer_rank());
+}
+}  // namespace rdc
+#endif
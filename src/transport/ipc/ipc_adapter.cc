@@ -1,15 +1,33 @@
+#ifdef RDC_USE_SHMEM
 #include "transport/ipc/ipc_adapter.h"
-#include "comm/tracker.h"
-#include "transport/ipc/ipc_channel.h"
+#include <algorithm>
+#include "common/env.h"
+#include "utils/string_utils.h"
 
 namespace rdc {
+// 4MB per direction
+const int kDefaultRingCapacity = 1 << 22;
+// below it the second copy through the ring is cheaper than a rendezvous
+const int kDefaultRndvThreshold = 1 << 18;
+// 1MB per rank and round of a shared memory collective
+const int kDefaultCollSlotSize = 1 << 20;
+
 IpcAdapter::IpcAdapter() {
-    ComputePrivateDataLocations();
-    auto&& rank = comm::Tracker::Get()->rank();
-    priv_data_.reset(new Shmem(std::to_string(rank),
-                               priv_data_locs_.size() * kMemFileNameSize));
-    std::memset(priv_data_->Data(), 0,
-                priv_data_locs_.size() * kMemFileNameSize);
+    this->set_backend(kIpc);
+    uint64_t capacity = std::max(
+        Env::Get()->GetEnv("RDC_IPC_RING_SIZE", kDefaultRingCapacity), 4096);
+    // indices are masked, so round up to a power of two
+    ring_capacity_ = 1;
+    while (ring_capacity_ < capacity) {
+        ring_capacity_ <<= 1;
+    }
+    rndv_threshold_ = std::max(
+        Env::Get()->GetEnv("RDC_IPC_RNDV_THRESHOLD", kDefaultRndvThreshold),
+        0);
+    // slots are cache line aligned
+    coll_slot_size_ = std::max(
+        Env::Get()->GetEnv("RDC_IPC_COLL_SLOT_SIZE", kDefaultCollSlotSize), 0);
+    coll_slot_size_ = (coll_slot_size_ + 63) / 64 * 64;
 }
 
 IpcAdapter* IpcAdapter::Get() {
@@ -17,49 +35,29 @@ IpcAdapter* IpcAdapter::Get() {
     return &adapter;
 }
 
-void IpcAdapter::SetPrivData(int rank, int peer_rank,
-                             char priv_data[kMemFileNameSize]) {
-    int loc = 0;
-    if (rank < peer_rank) {
-        loc = priv_data_locs_[std::make_tuple(rank, peer_rank)];
-    } else {
-        loc = priv_data_locs_[std::make_tuple(peer_rank, rank)];
-    }
-    std::memcpy(priv_data_->Data() + loc * kMemFileNameSize, priv_data,
-                kMemFileNameSize);
+std::string IpcAdapter::SegmentName(const std::string& comm, const int& rank,
+                                    const int& peer_rank) const {
+    // the tracker port tells apart jobs sharing a host
+    const char* tracker_port = Env::Get()->Find("RDC_TRACKER_PORT");
+    return str_utils::SPrintf("rdc-%s-%s-%d-%d",
+                              tracker_port ? tracker_port : "0", comm.c_str(),
+                              std::min(rank, peer_rank),
+                              std::max(rank, peer_rank));
 }
 
-void IpcAdapter::GetPrivData(int rank, int peer_rank,
-                             char priv_data[kMemFileNameSize]) {
-    int loc = 0;
-    if (rank < peer_rank) {
-        loc = priv_data_locs_[std::make_tuple(rank, peer_rank)];
-    } else {
-        loc = priv_data_locs_[std::make_tuple(peer_rank, rank)];
-    }
-    std::memcpy(priv_data, priv_data_->Data() + loc * kMemFileNameSize,
-                kMemFileNameSize);
-}
-
-void IpcAdapter::ComputePrivateDataLocations() {
-    int loc = 0;
-    auto&& peers_with_same_host = comm::Tracker::Get()->peers_with_same_host();
-    for (auto&& i = 0U; i < peers_with_same_host.size(); i++) {
-        for (auto&& j = i + 1; j < peers_with_same_host.size(); j++) {
-            auto&& peer_with_same_host = peers_with_same_host[i];
-            auto&& peer_with_same_host2 = peers_with_same_host[j];
-            priv_data_locs_[std::make_tuple(peer_with_same_host,
-                                            peer_with_same_host2)] = loc++;
-        }
-    }
+std::string IpcAdapter::ArenaName(const std::string& comm) const {
+    const char* tracker_port = Env::Get()->Find("RDC_TRACKER_PORT");
+    return str_utils::SPrintf("rdc-%s-%s-all",
+                              tracker_port ? tracker_port : "0", comm.c_str());
 }
 
 void IpcAdapter::Listen(const int& port) {
     return;
 }
 
-IChannel* Accept() {
-    auto channel = new IpcChannel();
+IChannel* IpcAdapter::Accept() {
+    auto channel = new IpcChannel(this);
     return channel;
 }
 }  // namespace rdc
+#endif
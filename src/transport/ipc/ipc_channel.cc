@@ -1,35 +1,199 @@
+#ifdef RDC_USE_SHMEM
 #include "transport/ipc/ipc_channel.h"
+#include <sys/uio.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
 #include "comm/tracker.h"
+#include "core/logging.h"
 #include "transport/ipc/ipc_adapter.h"
-#include "transport/ipc/ipc_utils.h"
 
 namespace rdc {
-WorkCompletion* IpcChannel::ISend(Buffer sendbuf) {
-    uint64_t send_req_id = WorkRequestManager::Get()->NewWorkRequest(
-        WorkType::kSend, sendbuf.addr(), sendbuf.size_in_bytes());
-    auto wc = WorkCompletion::New(send_req_id);
-    auto& send_req = WorkRequestManager::Get()->GetWorkRequest(send_req_id);
+namespace {
+const uint32_t kIpcSegmentMagic = 0x52444349;
+// how long the higher rank waits for the lower one to create the segment
+const int kIpcAttachTimeoutMs = 60 * 1000;
+/**
+ * @brief: first cache line of a segment, followed by the ring from the lower
+ * rank to the higher rank and the ring back
+ */
+struct IpcSegmentHeader {
+    alignas(64) std::atomic<uint32_t> magic;
+    uint64_t ring_capacity;
+    uint64_t rndv_threshold;
+};
 
-    char memfile_name_cstr[kMemFileNameSize];
-    std::memset(memfile_name_cstr, 0, kMemFileNameSize);
-    int peer_rank = this->peer_rank();
-    int rank = comm::Tracker::Get()->rank();
+enum LargeMessageMode : uint32_t {
+    // the payload follows the descriptor in the ring
+    kEager = 0,
+    // the receiver pulls the payload and replies
+    kPull = 1,
+};
 
-    std::string memfile_name =
-        compose_memfile_name(rank, peer_rank, send_counter_++);
+enum PullReply : uint32_t {
+    kPulled = 1,
+    kRefused = 2,
+};
+/**
+ * @brief: written into the ring ahead of every message above the threshold
+ */
+struct LargeMessageHeader {
+    uint64_t addr;
+    uint64_t size;
+    int32_t pid;
+    uint32_t mode;
+};
 
-    std::memcpy(memfile_name_cstr, memfile_name.c_str(), memfile_name.size());
-    
-    adapter_->SetPrivData(rank, peer_rank, memfile_name_cstr);
+/**
+ * @brief: copy size bytes at addr in process pid into dst, fails when the
+ * kernel does not allow us to read the peer, e.g. under yama ptrace scope
+ */
+bool PullFrom(const int32_t& pid, const uint64_t& addr, uint8_t* dst,
+              const uint64_t& size) {
+    uint64_t done = 0;
+    while (done < size) {
+        struct iovec local, remote;
+        local.iov_base = dst + done;
+        local.iov_len = size - done;
+        remote.iov_base = reinterpret_cast<void*>(addr + done);
+        remote.iov_len = size - done;
+        const ssize_t nbytes = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+        if (nbytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nbytes <= 0) {
+            LOG_F(WARNING, "process_vm_readv from process %d failed: %s", pid,
+                  strerror(errno));
+            return false;
+        }
+        done += nbytes;
+    }
+    return true;
+}
 
-    auto shm =
-        std::make_shared<Shmem>(memfile_name_cstr, send_req.size_in_bytes());
-    shm->Create();
-    std::memcpy(shm->Data(), send_req.pointer_at<uint8_t>(0),
-                send_req.size_in_bytes());
+inline uint64_t SegmentSize(const uint64_t& ring_capacity) {
+    return sizeof(IpcSegmentHeader) + 2 * ShmRing::SizeOf(ring_capacity);
+}
 
-    WorkRequestManager::Get()->set_status(send_req.id(), WorkStatus::kFinished);
-    send_req.Notify();
+inline void* RingAddr(Shm* shm, const uint64_t& ring_capacity,
+                      const int& index) {
+    return shm->Data() + sizeof(IpcSegmentHeader) +
+           index * ShmRing::SizeOf(ring_capacity);
+}
+}  // namespace
+
+IpcChannel::IpcChannel() : IpcChannel(IpcAdapter::Get()) {
+}
+
+IpcChannel::IpcChannel(IpcAdapter* adapter) : adapter_(adapter) {
+    this->set_kind(ChannelKind::kReadWrite);
+    this->set_error_detected(false);
+}
+
+IpcChannel::~IpcChannel() {
+    if (!closing_.load(std::memory_order_acquire)) {
+        this->Close();
+    }
+}
+
+bool IpcChannel::Attach() {
+    if (attached_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lg(attach_lock_);
+    if (attached_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    const auto& rank = comm::Tracker::Get()->rank();
+    const auto& capacity = adapter_->ring_capacity();
+    const bool creator = rank < peer_rank();
+    shm_.reset(new Shm(adapter_->SegmentName(comm(), rank, peer_rank()),
+                       SegmentSize(capacity)));
+    IpcSegmentHeader* header = nullptr;
+    if (creator) {
+        if (shm_->Create() != kOK) {
+            LOG_F(ERROR, "failed to create shared memory %s",
+                  shm_->Path().c_str());
+            return false;
+        }
+        header = new (shm_->Data()) IpcSegmentHeader;
+        header->ring_capacity = capacity;
+        header->rndv_threshold = adapter_->rndv_threshold();
+        send_ring_.Attach(RingAddr(shm_.get(), capacity, 0), capacity, true);
+        recv_ring_.Attach(RingAddr(shm_.get(), capacity, 1), capacity, true);
+        // publish the initialized rings
+        header->magic.store(kIpcSegmentMagic, std::memory_order_release);
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        while (shm_->Open() != kOK ||
+               reinterpret_cast<IpcSegmentHeader*>(shm_->Data())
+                       ->magic.load(std::memory_order_acquire) !=
+                   kIpcSegmentMagic) {
+            if (std::chrono::steady_clock::now() - start >
+                std::chrono::milliseconds(kIpcAttachTimeoutMs)) {
+                LOG_F(ERROR, "timeout waiting for shared memory %s",
+                      shm_->Path().c_str());
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            shm_.reset(new Shm(adapter_->SegmentName(comm(), rank, peer_rank()),
+                               SegmentSize(capacity)));
+        }
+        header = reinterpret_cast<IpcSegmentHeader*>(shm_->Data());
+        CHECK_F(header->ring_capacity == capacity,
+                "RDC_IPC_RING_SIZE differs between rank %d and %d", rank,
+                peer_rank());
+        if (header->rndv_threshold != adapter_->rndv_threshold()) {
+            LOG_F(WARNING,
+                  "RDC_IPC_RNDV_THRESHOLD differs between rank %d and %d, "
+                  "using %lu",
+                  rank, peer_rank(), header->rndv_threshold);
+        }
+        send_ring_.Attach(RingAddr(shm_.get(), capacity, 1), capacity, false);
+        recv_ring_.Attach(RingAddr(shm_.get(), capacity, 0), capacity, false);
+        // both ends are mapped, nothing else should find the segment
+        shm_->Unlink();
+    }
+    rndv_threshold_ = header->rndv_threshold;
+    send_thrd_ = std::thread([this] { this->SendLoop(); });
+    recv_thrd_ = std::thread([this] { this->RecvLoop(); });
+    attached_.store(true, std::memory_order_release);
+    return true;
+}
+
+bool IpcChannel::Connect(const std::string& host, const uint32_t& port) {
+    return Attach();
+}
+
+WorkCompletion* IpcChannel::ISend(Buffer sendbuf) {
+    uint64_t send_req_id = WorkRequestManager::Get()->NewWorkRequest(
+        WorkType::kSend, sendbuf.addr(), sendbuf.size_in_bytes());
+    auto wc = WorkCompletion::New(send_req_id);
+    auto& send_req = WorkRequestManager::Get()->GetWorkRequest(send_req_id);
+    if (!Attach()) {
+        WorkRequestManager::Get()->set_status(send_req_id, WorkStatus::kError);
+        send_req.Notify();
+        return wc;
+    }
+    // write right away when nothing is queued ahead, which is the common
+    // case for messages smaller than the ring, a rendezvous waits for the
+    // peer so it is always left to the send thread
+    send_lock_.lock();
+    if (send_reqs_.empty() && !IsLarge(send_req.size_in_bytes())) {
+        const auto& write_nbytes =
+            send_ring_.TryWrite(send_req.pointer_at<uint8_t>(0),
+                                send_req.size_in_bytes());
+        if (send_req.AddBytes(write_nbytes)) {
+            send_lock_.unlock();
+            WorkRequestManager::Get()->set_status(send_req_id,
+                                                  WorkStatus::kFinished);
+            send_req.Notify();
+            return wc;
+        }
+    }
+    send_reqs_.Push(send_req_id);
+    send_lock_.unlock();
     return wc;
 }
 
@@ -38,30 +202,178 @@ WorkCompletion* IpcChannel::IRecv(Buffer recvbuf) {
         WorkType::kRecv, recvbuf.addr(), recvbuf.size_in_bytes());
     auto wc = WorkCompletion::New(recv_req_id);
     auto& recv_req = WorkRequestManager::Get()->GetWorkRequest(recv_req_id);
+    if (!Attach()) {
+        WorkRequestManager::Get()->set_status(recv_req_id, WorkStatus::kError);
+        recv_req.Notify();
+        return wc;
+    }
+    recv_lock_.lock();
+    if (recv_reqs_.empty() && !IsLarge(recv_req.size_in_bytes())) {
+        const auto& read_nbytes = recv_ring_.TryRead(
+            recv_req.pointer_at<uint8_t>(0), recv_req.size_in_bytes());
+        if (recv_req.AddBytes(read_nbytes)) {
+            recv_lock_.unlock();
+            WorkRequestManager::Get()->set_status(recv_req_id,
+                                                  WorkStatus::kFinished);
+            recv_req.Notify();
+            return wc;
+        }
+    }
+    recv_reqs_.Push(recv_req_id);
+    recv_lock_.unlock();
+    return wc;
+}
 
-    int peer_rank = this->peer_rank();
-    int rank = comm::Tracker::Get()->rank();
-
-    char memfile_name_cstr[kMemFileNameSize];
-    adapter_->SetPrivData(rank, peer_rank, memfile_name_cstr);
+void IpcChannel::SendLoop() {
+    uint64_t send_req_id = -1;
+    while (!closing_.load(std::memory_order_acquire)) {
+        if (!send_reqs_.WaitAndPeek(send_req_id,
+                                    std::chrono::milliseconds(kCommTimeoutMs))) {
+            continue;
+        }
+        auto& send_req = WorkRequestManager::Get()->GetWorkRequest(send_req_id);
+        bool finished = false;
+        if (IsLarge(send_req.size_in_bytes())) {
+            finished = SendLarge(send_req);
+        } else {
+            const uint64_t remain = send_req.remain_nbytes();
+            finished = WriteAll(send_req.pointer_at<uint8_t>(
+                                    send_req.processed_bytes_upto_now()),
+                                remain) &&
+                       send_req.AddBytes(remain);
+        }
+        send_lock_.lock();
+        send_reqs_.Pop();
+        send_lock_.unlock();
+        WorkRequestManager::Get()->set_status(
+            send_req_id, finished ? WorkStatus::kFinished : WorkStatus::kClosed);
+        send_req.Notify();
+    }
+}
 
-    //auto&& info info_from_memfile_name(memfile_name);
-    auto shm =
-        std::make_shared<Shmem>(memfile_name_cstr, recv_req.size_in_bytes());
-    shm->Open();
-    recvbuf.set_addr(shm->Data());
-    recvbuf.set_shm(shm);
-    WorkRequestManager::Get()->set_status(recv_req.id(), WorkStatus::kFinished);
-    recv_req.Notify();
-    return wc;
+void IpcChannel::RecvLoop() {
+    uint64_t recv_req_id = -1;
+    while (!closing_.load(std::memory_order_acquire)) {
+        if (!recv_reqs_.WaitAndPeek(recv_req_id,
+                                    std::chrono::milliseconds(kCommTimeoutMs))) {
+            continue;
+        }
+        auto& recv_req = WorkRequestManager::Get()->GetWorkRequest(recv_req_id);
+        bool finished = false;
+        if (IsLarge(recv_req.size_in_bytes())) {
+            finished = RecvLarge(recv_req);
+        } else {
+            const uint64_t remain = recv_req.remain_nbytes();
+            finished = ReadAll(recv_req.pointer_at<uint8_t>(
+                                   recv_req.processed_bytes_upto_now()),
+                               remain) &&
+                       recv_req.AddBytes(remain);
+        }
+        recv_lock_.lock();
+        recv_reqs_.Pop();
+        recv_lock_.unlock();
+        WorkRequestManager::Get()->set_status(
+            recv_req_id, finished ? WorkStatus::kFinished : WorkStatus::kClosed);
+        recv_req.Notify();
+    }
 }
 
-void IpcChannel::Close() {
-    return;
+bool IpcChannel::WriteAll(const void* data, const uint64_t& nbytes) {
+    const auto* src = reinterpret_cast<const uint8_t*>(data);
+    uint64_t done = 0;
+    while (done < nbytes) {
+        if (closing_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const uint64_t write_nbytes =
+            send_ring_.TryWrite(src + done, nbytes - done);
+        if (write_nbytes == 0) {
+            send_ring_.WaitWritable(kCommTimeoutMs);
+        }
+        done += write_nbytes;
+    }
+    return true;
 }
 
-bool IpcChannel::Connect(const std::string& host, const uint32_t& port) {
+bool IpcChannel::ReadAll(void* data, const uint64_t& nbytes) {
+    auto* dst = reinterpret_cast<uint8_t*>(data);
+    uint64_t done = 0;
+    while (done < nbytes) {
+        if (closing_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const uint64_t read_nbytes = recv_ring_.TryRead(dst + done,
+                                                        nbytes - done);
+        if (read_nbytes == 0) {
+            recv_ring_.WaitReadable(kCommTimeoutMs);
+        }
+        done += read_nbytes;
+    }
     return true;
 }
 
+bool IpcChannel::SendLarge(WorkRequest& send_req) {
+    LargeMessageHeader header;
+    header.addr = reinterpret_cast<uint64_t>(send_req.pointer_at<uint8_t>(0));
+    header.size = send_req.size_in_bytes();
+    header.pid = getpid();
+    header.mode = rndv_refused_ ? kEager : kPull;
+    if (!WriteAll(&header, sizeof(header))) {
+        return false;
+    }
+    if (header.mode == kPull) {
+        // the buffer must stay untouched until the peer is done reading it
+        ++rndv_count_;
+        while (!send_ring_.WaitReply(rndv_count_, kCommTimeoutMs)) {
+            if (closing_.load(std::memory_order_acquire)) {
+                return false;
+            }
+        }
+        if (send_ring_.reply() == kPulled) {
+            return send_req.AddBytes(header.size);
+        }
+        LOG_F(WARNING,
+              "rank %d can not read the memory of rank %d, large messages "
+              "go through shared memory",
+              peer_rank(), comm::Tracker::Get()->rank());
+        rndv_refused_ = true;
+    }
+    return WriteAll(send_req.pointer_at<uint8_t>(0), header.size) &&
+           send_req.AddBytes(header.size);
+}
+
+bool IpcChannel::RecvLarge(WorkRequest& recv_req) {
+    LargeMessageHeader header;
+    if (!ReadAll(&header, sizeof(header))) {
+        return false;
+    }
+    CHECK_F(header.size == recv_req.size_in_bytes(),
+            "rank %d sent %lu bytes but %lu bytes are expected", peer_rank(),
+            header.size, recv_req.size_in_bytes());
+    auto* dst = recv_req.pointer_at<uint8_t>(0);
+    if (header.mode == kPull) {
+        if (PullFrom(header.pid, header.addr, dst, header.size)) {
+            recv_ring_.Reply(kPulled);
+            return recv_req.AddBytes(header.size);
+        }
+        // the sender streams the payload after this
+        recv_ring_.Reply(kRefused);
+    }
+    return ReadAll(dst, header.size) && recv_req.AddBytes(header.size);
+}
+
+void IpcChannel::Close() {
+    closing_.store(true, std::memory_order_release);
+    if (attached_.load(std::memory_order_acquire)) {
+        send_ring_.Wake();
+        recv_ring_.Wake();
+        send_thrd_.join();
+        recv_thrd_.join();
+        attached_.store(false, std::memory_order_release);
+    }
+    shm_.reset();
+    LOG_F(INFO, "channel with parent communicator %s from %d to %d is closed",
+          comm().c_str(), comm::Tracker::Get()->rank(), peer_rank());
+}
 }  // namespace rdc
+#endif
@@ -18,14 +18,14 @@ ShmError Shm::CreateOrOpen(bool create) {
             return kErrorCreationFailed;
         }
     } else {
-        handle_ = OpenFileMappingA(FILE_MAP_READ, FALSE, path_.c_str());
+        handle_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, path_.c_str());
 
         if (!handle_) {
             return kErrorOpeningFailed;
         }
     }
 
-    DWORD access = create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ;
+    DWORD access = FILE_MAP_ALL_ACCESS;
 
     data_ = static_cast<uint8_t*>(MapViewOfFile(handle_, access, 0, 0, size_));
 
@@ -36,6 +36,10 @@ ShmError Shm::CreateOrOpen(bool create) {
     return kOK;
 }
 
+// named mappings go away with their last handle
+void Shm::Unlink() {
+}
+
 /**
  * Destructor
  */
@@ -78,7 +82,7 @@ ShmError Shm::CreateOrOpen(bool create) {
         }
     }
 
-    int flags = create ? (O_CREAT | O_RDWR) : O_RDONLY;
+    int flags = create ? (O_CREAT | O_RDWR) : O_RDWR;
 
     fd_ = shm_open(path_.c_str(), flags, 0755);
     if (fd_ < 0) {
@@ -96,25 +100,44 @@ ShmError Shm::CreateOrOpen(bool create) {
         if (ret != 0) {
             return kErrorCreationFailed;
         }
+    } else {
+        // touching pages past the end of a segment which is not sized yet
+        // raises SIGBUS
+        struct stat st;
+        if (fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < size_) {
+            close(fd_);
+            fd_ = -1;
+            return kErrorOpeningFailed;
+        }
     }
 
-    int prot = create ? (PROT_READ | PROT_WRITE) : PROT_READ;
-
-    data_ =
-        static_cast<uint8_t *>(mmap(nullptr, size_, prot, MAP_SHARED, fd_, 0));
+    void *data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
 
-    if (!data_) {
+    if (data == MAP_FAILED) {
         return kErrorMappingFailed;
     }
+    data_ = static_cast<uint8_t *>(data);
+    created_ = create;
 
     return kOK;
 }
 
-Shm::~Shm() {
-    munmap(data_, size_);
-    close(fd_);
+void Shm::Unlink() {
     shm_unlink(path_.c_str());
 }
 
+Shm::~Shm() {
+    if (data_) {
+        munmap(data_, size_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    // a failed open must not remove the segment of its creator
+    if (created_) {
+        shm_unlink(path_.c_str());
+    }
+}
+
 }  // namespace rdc
 #endif
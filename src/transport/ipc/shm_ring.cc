@@ -0,0 +1,166 @@
+#ifdef RDC_USE_SHMEM
+#include "transport/ipc/shm_ring.h"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <new>
+
+namespace rdc {
+namespace {
+// polls for a few microseconds before going to sleep, a peer on another
+// core usually answers within that, a futex round trip costs much more
+const int kSpinCount = 256;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// shared mapping, so no FUTEX_PRIVATE_FLAG
+inline void FutexWait(std::atomic<uint32_t>* addr, const uint32_t& expected,
+                      const int& timeout_ms) {
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT,
+            expected, &timeout, nullptr, 0);
+}
+
+inline void FutexWake(std::atomic<uint32_t>* addr) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, INT_MAX,
+            nullptr, nullptr, 0);
+}
+
+inline void Ring(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* waiters) {
+    seq->fetch_add(1, std::memory_order_seq_cst);
+    if (waiters->load(std::memory_order_seq_cst) != 0) {
+        FutexWake(seq);
+    }
+}
+
+template <typename Ready>
+inline void WaitOn(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* waiters,
+                   const int& timeout_ms, Ready ready) {
+    for (int i = 0; i < kSpinCount; ++i) {
+        if (ready()) {
+            return;
+        }
+        CpuRelax();
+    }
+    // the sequence is read before the final check, so a ring in between
+    // makes the futex wait return immediately
+    const auto& expected = seq->load(std::memory_order_seq_cst);
+    if (ready()) {
+        return;
+    }
+    waiters->fetch_add(1, std::memory_order_seq_cst);
+    FutexWait(seq, expected, timeout_ms);
+    waiters->fetch_sub(1, std::memory_order_seq_cst);
+}
+}  // namespace
+
+void ShmRing::Attach(void* addr, const uint64_t& capacity, const bool& init) {
+    header_ = reinterpret_cast<ShmRingHeader*>(addr);
+    data_ = reinterpret_cast<uint8_t*>(addr) + sizeof(ShmRingHeader);
+    capacity_ = capacity;
+    if (init) {
+        new (header_) ShmRingHeader;
+        header_->head.store(0, std::memory_order_relaxed);
+        header_->tail.store(0, std::memory_order_relaxed);
+        header_->data_seq.store(0, std::memory_order_relaxed);
+        header_->data_waiters.store(0, std::memory_order_relaxed);
+        header_->space_seq.store(0, std::memory_order_relaxed);
+        header_->space_waiters.store(0, std::memory_order_relaxed);
+        header_->reply_seq.store(0, std::memory_order_relaxed);
+        header_->reply_waiters.store(0, std::memory_order_relaxed);
+        header_->reply.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t ShmRing::readable() const {
+    return header_->head.load(std::memory_order_acquire) -
+           header_->tail.load(std::memory_order_relaxed);
+}
+
+uint64_t ShmRing::writable() const {
+    return capacity_ - (header_->head.load(std::memory_order_relaxed) -
+                        header_->tail.load(std::memory_order_acquire));
+}
+
+uint64_t ShmRing::TryWrite(const void* data, const uint64_t& nbytes) {
+    const auto& head = header_->head.load(std::memory_order_relaxed);
+    const auto& tail = header_->tail.load(std::memory_order_acquire);
+    const uint64_t len = std::min(nbytes, capacity_ - (head - tail));
+    if (len == 0) {
+        return 0;
+    }
+    const auto& pos = head & (capacity_ - 1);
+    const uint64_t first = std::min(len, capacity_ - pos);
+    const auto* src = reinterpret_cast<const uint8_t*>(data);
+    std::memcpy(data_ + pos, src, first);
+    std::memcpy(data_, src + first, len - first);
+    header_->head.store(head + len, std::memory_order_release);
+    Ring(&header_->data_seq, &header_->data_waiters);
+    return len;
+}
+
+uint64_t ShmRing::TryRead(void* data, const uint64_t& nbytes) {
+    const auto& tail = header_->tail.load(std::memory_order_relaxed);
+    const auto& head = header_->head.load(std::memory_order_acquire);
+    const uint64_t len = std::min(nbytes, head - tail);
+    if (len == 0) {
+        return 0;
+    }
+    const auto& pos = tail & (capacity_ - 1);
+    const uint64_t first = std::min(len, capacity_ - pos);
+    auto* dst = reinterpret_cast<uint8_t*>(data);
+    std::memcpy(dst, data_ + pos, first);
+    std::memcpy(dst + first, data_, len - first);
+    header_->tail.store(tail + len, std::memory_order_release);
+    Ring(&header_->space_seq, &header_->space_waiters);
+    return len;
+}
+
+void ShmRing::WaitReadable(const int& timeout_ms) {
+    WaitOn(&header_->data_seq, &header_->data_waiters, timeout_ms,
+           [this] { return this->readable() != 0; });
+}
+
+void ShmRing::WaitWritable(const int& timeout_ms) {
+    WaitOn(&header_->space_seq, &header_->space_waiters, timeout_ms,
+           [this] { return this->writable() != 0; });
+}
+
+void ShmRing::Reply(const uint32_t& reply) {
+    header_->reply.store(reply, std::memory_order_release);
+    Ring(&header_->reply_seq, &header_->reply_waiters);
+}
+
+bool ShmRing::WaitReply(const uint32_t& count, const int& timeout_ms) {
+    auto answered = [this, count] {
+        // a later answer implies this one, the count may wrap around
+        return static_cast<int32_t>(
+                   header_->reply_seq.load(std::memory_order_acquire) -
+                   count) >= 0;
+    };
+    WaitOn(&header_->reply_seq, &header_->reply_waiters, timeout_ms,
+           answered);
+    return answered();
+}
+
+void ShmRing::Wake() {
+    Ring(&header_->data_seq, &header_->data_waiters);
+    Ring(&header_->space_seq, &header_->space_waiters);
+    // the reply sequence counts answers the producer waits for, bumping it
+    // would pass for one, so only wake it to look at its closing flag
+    if (header_->reply_waiters.load(std::memory_order_seq_cst) != 0) {
+        FutexWake(&header_->reply_seq);
+    }
+}
+}  // namespace rdc
+#endif
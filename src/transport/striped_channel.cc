@@ -0,0 +1,105 @@
+#include "transport/striped_channel.h"
+#include <algorithm>
+#include <atomic>
+#include "core/logging.h"
+
+namespace rdc {
+StripedChannel::StripedChannel(
+    const std::vector<std::shared_ptr<IChannel>>& stripes,
+    const uint64_t& threshold)
+    : IChannel(ChannelKind::kReadWrite),
+      stripes_(stripes),
+      threshold_(threshold) {
+    CHECK_F(!stripes_.empty(), "a striped channel needs at least one stripe");
+}
+
+StripedChannel::~StripedChannel() {
+    this->Close();
+}
+
+bool StripedChannel::Connect(const std::string& hostname,
+                             const uint32_t& port) {
+    for (auto& stripe : stripes_) {
+        if (!stripe->Connect(hostname, port)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+WorkCompletion* StripedChannel::ISend(Buffer sendbuf) {
+    return Post(false, sendbuf);
+}
+
+WorkCompletion* StripedChannel::IRecv(Buffer recvbuf) {
+    return Post(true, recvbuf);
+}
+
+void StripedChannel::Close() {
+    for (auto& stripe : stripes_) {
+        stripe->Close();
+    }
+    stripes_.clear();
+}
+
+WorkCompletion* StripedChannel::Post(const bool& is_recv, Buffer buf) {
+    auto* stripe_lock = is_recv ? &recv_lock_ : &send_lock_;
+    if (buf.size_in_bytes() < threshold_ || stripes_.size() == 1) {
+        std::lock_guard<std::mutex> lg(*stripe_lock);
+        return is_recv ? stripes_.front()->IRecv(buf)
+                       : stripes_.front()->ISend(buf);
+    }
+    const uint64_t req_id = WorkRequestManager::Get()->NewWorkRequest(
+        is_recv ? WorkType::kRecv : WorkType::kSend, buf.addr(),
+        buf.size_in_bytes());
+    auto wc = WorkCompletion::New(req_id);
+    // one count per part plus one released after posting, so that the
+    // request can not finish while parts are still being posted
+    struct Parts {
+        std::atomic<int32_t> pending;
+        std::atomic<WorkStatus> status;
+    };
+    auto parts = std::make_shared<Parts>();
+    parts->pending.store(stripes_.size() + 1, std::memory_order_relaxed);
+    parts->status.store(WorkStatus::kFinished, std::memory_order_relaxed);
+    auto on_part_done = [this, parts, req_id](const WorkStatus& status) {
+        if (status != WorkStatus::kFinished) {
+            auto expected = WorkStatus::kFinished;
+            parts->status.compare_exchange_strong(expected, status,
+                                                  std::memory_order_acq_rel);
+            this->set_error_detected(true);
+        }
+        if (parts->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        auto& work_req = WorkRequestManager::Get()->GetWorkRequest(req_id);
+        const auto& final_status =
+            parts->status.load(std::memory_order_acquire);
+        if (final_status == WorkStatus::kFinished) {
+            work_req.AddBytes(work_req.size_in_bytes());
+        }
+        work_req.set_status(final_status);
+        work_req.Notify();
+    };
+    const uint64_t part_size =
+        (buf.size_in_bytes() + stripes_.size() - 1) / stripes_.size();
+    {
+        std::lock_guard<std::mutex> lg(*stripe_lock);
+        for (auto i = 0U; i < stripes_.size(); i++) {
+            const uint64_t start =
+                std::min(i * part_size, buf.size_in_bytes());
+            const uint64_t end =
+                std::min(start + part_size, buf.size_in_bytes());
+            auto part = buf.Slice(start, end);
+            auto part_wc = is_recv ? stripes_[i]->IRecv(part)
+                                   : stripes_[i]->ISend(part);
+            part_wc->OnDone([on_part_done, part_wc](const WorkStatus& status) {
+                on_part_done(status);
+                WorkCompletion::Delete(part_wc);
+            });
+        }
+    }
+    on_part_done(WorkStatus::kFinished);
+    return wc;
+}
+}  // namespace rdc
@@ -330,6 +330,20 @@ ssize_t TcpSocket::Recv(void *buf_, size_t len, int flags) {
     return recv(sockfd, buf, static_cast<sock_size_t>(len), flags);
 }
 
+#if !defined(_WIN32)
+ssize_t TcpSocket::SendV(const struct iovec *iov, int iovcnt, int flags) {
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = const_cast<struct iovec *>(iov);
+    msg.msg_iovlen = iovcnt;
+    return sendmsg(sockfd, &msg, flags);
+}
+
+ssize_t TcpSocket::RecvV(const struct iovec *iov, int iovcnt) {
+    return readv(sockfd, iov, iovcnt);
+}
+#endif
+
 size_t TcpSocket::SendAll(const void *buf_, size_t len) {
     const char *buf = reinterpret_cast<const char *>(buf_);
     size_t ndone = 0;
@@ -1,6 +1,8 @@
 #include "transport/tcp/tcp_adapter.h"
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
 #include <string.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
@@ -13,12 +15,15 @@
 #include <thread>
 #include <unordered_map>
 #include <vector>
+#include "common/env.h"
 #include "common/status.h"
 #include "common/threadpool.h"
 #include "core/logging.h"
 #include "sys/error.h"
 #include "transport/tcp/tcp_channel.h"
 static const uint32_t kNumMaxEvents = 1024;
+// one poller keeps up with a single nic, raise it for several fast ones
+static const int32_t kDefaultNumPollers = 1;
 
 namespace rdc {
 static inline uint32_t channel_kind_to_epoll_event(
@@ -77,40 +82,86 @@ TcpAdapter::TcpAdapter() {
     this->set_backend(kTcp);
     this->listen_sock_ = TcpSocket();
     this->shutdown_called_ = false;
+    this->shutdown_ = false;
     this->shutdown_fd_ = -1;
     this->timeout_ = -1;
-    this->epoll_fd_ = epoll_create(kNumMaxEvents);
+    const int32_t num_pollers = std::max(
+        Env::Get()->GetEnv("RDC_TCP_NUM_POLLERS", kDefaultNumPollers), 1);
+    this->first_poller_core_ = Env::Get()->GetEnv("RDC_TCP_POLLER_CORE", -1);
+    this->edge_triggered_ = Env::Get()->GetEnv("RDC_TCP_EDGE_TRIGGERED", 0) != 0;
+    this->zerocopy_threshold_ =
+        Env::Get()->GetEnv("RDC_TCP_ZEROCOPY_THRESHOLD", 0UL);
+    for (int32_t i = 0; i < num_pollers; i++) {
+        shards_.emplace_back(new TcpPollerShard);
+        shards_.back()->epoll_fd = epoll_create(kNumMaxEvents);
+    }
     PollForever();
 }
 
 void TcpAdapter::PollForever() {
-    loop_thrd = std::unique_ptr<std::thread>(new std::thread([this]() {
-        logging::set_thread_name("tcppoller");
-        LOG_F(2, "Tcp poller Started");
-        while (true) {
-            bool finished = Poll();
-            if (finished)
-                break;
+    for (auto i = 0U; i < shards_.size(); i++) {
+        auto& shard = *shards_[i];
+        auto loop = [this, &shard, i]() {
+            logging::set_thread_name(("tcppoller" + std::to_string(i)).c_str());
+            LOG_F(2, "Tcp poller %u Started", i);
+            while (true) {
+                bool finished = Poll(shard);
+                if (finished)
+                    break;
+            }
+        };
+        shard.thrd = std::unique_ptr<std::thread>(new std::thread(loop));
+        if (first_poller_core_ >= 0) {
+            const uint32_t num_cores =
+                std::max(std::thread::hardware_concurrency(), 1U);
+            const int core = (first_poller_core_ + i) % num_cores;
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(core, &cpuset);
+            if (pthread_setaffinity_np(shard.thrd->native_handle(),
+                                       sizeof(cpuset), &cpuset) != 0) {
+                LOG_F(WARNING, "failed to pin tcp poller %u to core %d", i,
+                      core);
+            }
         }
-    }));
+    }
 }
 TcpAdapter::~TcpAdapter() {
     this->Shutdown();
-    this->loop_thrd->join();
-    CloseSocket(this->epoll_fd_);
+    for (auto& shard : shards_) {
+        shard->thrd->join();
+        CloseSocket(shard->epoll_fd);
+    }
     this->listen_sock_.Close();
 }
 void TcpAdapter::AddChannel(int32_t fd, TcpChannel* channel) {
-    lock_.lock();
-    channels_[fd] = channel;
+    auto& shard = ShardOf(fd);
+    shard.lock.lock();
+    shard.channels[fd] = channel;
     LOG_F(2, "Add new channel with fd : %d", fd);
     uint32_t flags = channel_kind_to_epoll_event(channel->kind());
+    if (edge_triggered_) {
+        // registered once for both directions, drains stop at EAGAIN
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        flags = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    }
     epoll_event ev;
     std::memset(&ev, 0, sizeof(ev));
     ev.data.fd = fd;
     ev.events |= flags;
-    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
-    lock_.unlock();
+    epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    shard.lock.unlock();
+#ifdef SO_ZEROCOPY
+    if (zerocopy_threshold_ != 0) {
+        const int one = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+            channel->EnableZeroCopy(zerocopy_threshold_);
+        } else {
+            LOG_F(WARNING, "zero copy unavailable on fd %d: %s", fd,
+                  sys::FormatError(errno).c_str());
+        }
+    }
+#endif
 }
 
 void TcpAdapter::AddChannel(TcpChannel* channel) {
@@ -118,20 +169,25 @@ void TcpAdapter::AddChannel(TcpChannel* channel) {
 }
 
 void TcpAdapter::RemoveChannel(TcpChannel* channel) {
-    lock_.lock();
-    channels_.erase(channel->sockfd());
-    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, channel->sockfd(), nullptr);
-    lock_.unlock();
+    auto& shard = ShardOf(channel->sockfd());
+    shard.lock.lock();
+    shard.channels.erase(channel->sockfd());
+    epoll_ctl(shard.epoll_fd, EPOLL_CTL_DEL, channel->sockfd(), nullptr);
+    shard.lock.unlock();
 }
 
 void TcpAdapter::ModifyChannel(TcpChannel* channel,
                                const ChannelKind& target_kind) {
+    if (edge_triggered_) {
+        return;
+    }
     epoll_event ev;
     std::memset(&ev, 0, sizeof(ev));
     ev.data.fd = channel->sockfd();
     uint32_t flags = channel_kind_to_epoll_event(target_kind);
     ev.events |= flags;
-    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, channel->sockfd(), &ev);
+    epoll_ctl(ShardOf(channel->sockfd()).epoll_fd, EPOLL_CTL_MOD,
+              channel->sockfd(), &ev);
 }
 
 void TcpAdapter::Shutdown() {
@@ -142,11 +198,14 @@ void TcpAdapter::Shutdown() {
         pipe(pipe_fd);
         int flags = EPOLLIN;
         this->shutdown_fd_ = pipe_fd[0];
-        epoll_event ev;
-        std::memset(&ev, 0, sizeof(ev));
-        ev.data.fd = shutdown_fd_;
-        ev.events |= flags;
-        epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, this->shutdown_fd_, &ev);
+        // never read, so it wakes every poller
+        for (auto& shard : shards_) {
+            epoll_event ev;
+            std::memset(&ev, 0, sizeof(ev));
+            ev.data.fd = shutdown_fd_;
+            ev.events |= flags;
+            epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, this->shutdown_fd_, &ev);
+        }
         write(pipe_fd[1], "shutdown", 9);
     }
     shutdown_lock_.unlock();
@@ -157,22 +216,51 @@ void TcpAdapter::Shutdown() {
  * event loop use TcpAdapter_loop
  * /return whether poll finished
  */
-bool TcpAdapter::Poll() {
+bool TcpAdapter::Poll(TcpPollerShard& shard) {
     epoll_event events[kNumMaxEvents];
     int fds =
-        epoll_wait(this->epoll_fd_, events, kNumMaxEvents, this->timeout_);
+        epoll_wait(shard.epoll_fd, events, kNumMaxEvents, this->timeout_);
     for (int i = 0; i < fds; i++) {
         TcpChannel* channel = nullptr;
-        lock_.lock();
-        channel = this->channels_[events[i].data.fd];
-        lock_.unlock();
+        shard.lock.lock();
+        auto it = shard.channels.find(events[i].data.fd);
+        if (it != shard.channels.end()) {
+            channel = it->second;
+        }
+        shard.lock.unlock();
         if (channel) {
-            // shutdown or error
+            // completions of zero copy sends are queued as socket errors
+            if ((events[i].events & EPOLLERR) && channel->zerocopy() &&
+                channel->ReapZeroCopy() &&
+                GetLastSocketError(events[i].data.fd) == 0) {
+                events[i].events &= ~EPOLLERR;
+            }
+            // the peer shut its side, what it sent before is still read once
+            // receives are posted, reading its end fails the ones left
+            if (edge_triggered_ &&
+                !(events[i].events & (EPOLLERR | EPOLLHUP))) {
+                if (IsReadEvent(events[i].events) ||
+                    events[i].events & EPOLLRDHUP) {
+                    channel->DrainRecv();
+                }
+                if (IsWriteEvent(events[i].events)) {
+                    channel->DrainSend();
+                }
+                continue;
+            }
+            // shutdown or error, stop watching this socket only, the other
+            // channels of the shard, the tracker among them, keep polling
             if (IsErrorEvent(events[i].events)) {
                 int32_t error = GetLastSocketError(events[i].data.fd);
                 channel->set_error_detected(true);
                 LOG_F(ERROR, "%s", sys::FormatError(error).c_str());
-                return true;
+                if (edge_triggered_) {
+                    // no further edge comes for the requests still queued
+                    channel->DrainRecv();
+                    channel->DrainSend();
+                }
+                RemoveChannel(channel);
+                continue;
             }
 
             // when data avaliable for read or urgent flag is set
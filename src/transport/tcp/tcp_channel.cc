@@ -1,13 +1,16 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <linux/errqueue.h>
 #include <netinet/in.h>
 #include <string.h>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <cstring>
+#include <vector>
 
 #include "common/status.h"
 #include "core/work_request.h"
@@ -17,6 +20,11 @@
 #include "transport/tcp/tcp_adapter.h"
 #include "transport/tcp/tcp_channel.h"
 namespace rdc {
+namespace {
+// most sends gathered by one write or receives scattered by one read
+const size_t kMaxBatch = 64;
+}  // namespace
+
 TcpChannel::TcpChannel() {
     this->adapter_ = nullptr;
     this->sock_ = TcpSocket();
@@ -71,6 +79,18 @@ void TcpChannel::Close() {
     if (!sock_.IsClosed()) {
         sock_.Close();
     }
+    // nobody reaps notifications anymore, give up on pages still held
+    zerocopy_lock_.lock();
+    auto zerocopy_reqs = std::move(zerocopy_reqs_);
+    zerocopy_reqs_.clear();
+    zerocopy_lock_.unlock();
+    for (const auto& zerocopy_req : zerocopy_reqs) {
+        auto& send_req =
+            WorkRequestManager::Get()->GetWorkRequest(zerocopy_req.second);
+        WorkRequestManager::Get()->set_status(zerocopy_req.second,
+                                              WorkStatus::kClosed);
+        send_req.Notify();
+    }
     LOG_F(INFO, "channel with parent communicator %s from %d to %d is closed",
           comm().c_str(), GetRank(), peer_rank());
 }
@@ -100,28 +120,48 @@ WorkCompletion* TcpChannel::ISend(const Buffer sendbuf) {
     uint64_t send_req_id = WorkRequestManager::Get()->NewWorkRequest(
         WorkType::kSend, sendbuf.addr(), sendbuf.size_in_bytes());
     auto wc = WorkCompletion::New(send_req_id);
+    if (edge_triggered()) {
+        send_reqs_.Push(send_req_id);
+        DrainSend();
+        return wc;
+    }
     auto& send_req = WorkRequestManager::Get()->GetWorkRequest(send_req_id);
+    send_drain_lock_.lock();
+    // earlier sends are still queued, writing now would reorder the stream
+    send_lock_.lock();
+    if (!send_reqs_.empty()) {
+        send_reqs_.Push(send_req_id);
+        send_lock_.unlock();
+        send_drain_lock_.unlock();
+        return wc;
+    }
+    send_lock_.unlock();
+    WorkStatus status = WorkStatus::kPending;
     do {
-        const auto& write_nbytes = sock_.Send(
-            send_req.pointer_at<uint8_t>(send_req.processed_bytes_upto_now()),
-            send_req.remain_nbytes());
+        const auto& write_nbytes = SendHead(send_req);
         if (write_nbytes > 0) {
-            if (send_req.AddBytes(write_nbytes)) {
-                WorkRequestManager::Get()->set_status(send_req.id(),
-                                                      WorkStatus::kFinished);
-                send_req.Notify();
+            if (send_req.AddBytes(write_nbytes, !head_zerocopy_)) {
+                if (!HoldZeroCopy(send_req_id, head_zerocopy_,
+                                  head_zerocopy_id_)) {
+                    status = WorkStatus::kFinished;
+                }
+                break;
             }
         } else if (write_nbytes == -1 && errno == EAGAIN) {
+            send_lock_.lock();
             send_reqs_.Push(send_req_id);
+            send_lock_.unlock();
             this->AddEventOfInterest(ChannelKind::kWrite);
             break;
         } else {
-            WorkRequestManager::Get()->set_status(send_req.id(),
-                                                  WorkStatus::kError);
-            send_req.Notify();
-            send_reqs_.Pop();
+            status = WorkStatus::kError;
+            break;
         }
     } while (send_req.status() != WorkStatus::kFinished);
+    send_drain_lock_.unlock();
+    if (status != WorkStatus::kPending) {
+        Finish({send_req_id}, status);
+    }
     return wc;
 }
 
@@ -130,9 +170,68 @@ WorkCompletion* TcpChannel::IRecv(Buffer recvbuf) {
         WorkType::kRecv, recvbuf.addr(), recvbuf.size_in_bytes());
     auto wc = WorkCompletion::New(recv_req_id);
     recv_reqs_.Push(recv_req_id);
+    if (edge_triggered()) {
+        // data which arrived before the request raises no further edge
+        DrainRecv();
+    }
     return wc;
 }
 
+ChainWorkCompletion* TcpChannel::ISendv(const std::vector<Buffer>& sendbufs) {
+    auto chain_wc = ChainWorkCompletion::New();
+    std::vector<uint64_t> send_req_ids;
+    for (const auto& sendbuf : sendbufs) {
+        send_req_ids.emplace_back(WorkRequestManager::Get()->NewWorkRequest(
+            WorkType::kSend, sendbuf.addr(), sendbuf.size_in_bytes()));
+        chain_wc->Add(WorkCompletion::New(send_req_ids.back()));
+    }
+    send_lock_.lock();
+    const bool idle = send_reqs_.empty();
+    for (const auto& send_req_id : send_req_ids) {
+        send_reqs_.Push(send_req_id);
+    }
+    send_lock_.unlock();
+    if (edge_triggered()) {
+        DrainSend();
+        return chain_wc;
+    }
+    // written by the poller after the earlier sends
+    if (!idle) {
+        return chain_wc;
+    }
+    std::vector<uint64_t> done_reqs;
+    std::vector<uint64_t> failed_reqs;
+    // the poller may have been armed by an earlier send and write the same
+    // head meanwhile
+    send_drain_lock_.lock();
+    while (true) {
+        const auto write_nbytes = SendQueued(&done_reqs);
+        if (write_nbytes == -1 && errno == EAGAIN) {
+            this->AddEventOfInterest(ChannelKind::kWrite);
+            break;
+        }
+        if (write_nbytes == -1) {
+            this->set_error_detected(true);
+            uint64_t send_req_id = 0;
+            while (send_reqs_.TryPeek(send_req_id)) {
+                send_reqs_.Pop();
+                failed_reqs.emplace_back(send_req_id);
+            }
+            break;
+        }
+        send_lock_.lock();
+        const bool more_sends = !send_reqs_.empty();
+        send_lock_.unlock();
+        if (!more_sends) {
+            break;
+        }
+    }
+    send_drain_lock_.unlock();
+    Finish(done_reqs, WorkStatus::kFinished);
+    Finish(failed_reqs, WorkStatus::kError);
+    return chain_wc;
+}
+
 void TcpChannel::ReadCallback() {
     uint64_t recv_req_id = -1;
     if (closing_.load(std::memory_order_acquire)) {
@@ -151,10 +250,12 @@ void TcpChannel::ReadCallback() {
         LOG_F(ERROR, "error detected %s", sys::GetLastErrorString().c_str());
         recv_req.Notify();
         recv_reqs_.Pop();
+        return;
     }
-    auto read_nbytes = sock_.Recv(
-        recv_req.pointer_at<uint8_t>(recv_req.processed_bytes_upto_now()),
-        recv_req.remain_nbytes());
+    const bool head_filled = recv_req.remain_nbytes() == 0;
+    std::vector<uint64_t> done_reqs;
+    auto read_nbytes = RecvQueued(&done_reqs);
+    Finish(done_reqs, WorkStatus::kFinished);
     if (read_nbytes == -1 && errno != EAGAIN) {
         this->set_error_detected(true);
         LOG_F(ERROR, "error detected %s", sys::FormatError(errno).c_str());
@@ -162,12 +263,17 @@ void TcpChannel::ReadCallback() {
                                               WorkStatus::kError);
         recv_req.Notify();
         recv_reqs_.Pop();
+        return;
     }
-    if (recv_req.AddBytes(read_nbytes)) {
+    // closed by the peer, a read which stays posted would never finish
+    if (read_nbytes == 0 && !head_filled) {
+        this->set_error_detected(true);
+        LOG_F(ERROR, "channel to %d closed by peer", peer_rank());
         WorkRequestManager::Get()->set_status(recv_req.id(),
-                                              WorkStatus::kFinished);
+                                              WorkStatus::kError);
         recv_req.Notify();
         recv_reqs_.Pop();
+        return;
     }
     return;
 }
@@ -181,33 +287,319 @@ void TcpChannel::WriteCallback() {
         }
         return;
     }
-    auto& send_req = WorkRequestManager::Get()->GetWorkRequest(send_req_id);
+    // an inline write of the posting thread may have taken the head
+    send_drain_lock_.lock();
+    if (!send_reqs_.TryPeek(send_req_id)) {
+        send_drain_lock_.unlock();
+        return;
+    }
     if (this->error_detected()) {
-        WorkRequestManager::Get()->set_status(send_req_id, WorkStatus::kError);
-        send_req.Notify();
         send_reqs_.Pop();
+        send_drain_lock_.unlock();
+        Finish({send_req_id}, WorkStatus::kError);
+        return;
     }
 
-    auto write_nbytes = sock_.Send(
-        send_req.pointer_at<uint8_t>(send_req.processed_bytes_upto_now()),
-        send_req.remain_nbytes());
+    std::vector<uint64_t> done_reqs;
+    auto write_nbytes = SendQueued(&done_reqs);
     if (write_nbytes == -1 && errno != EAGAIN) {
         this->set_error_detected(true);
-        WorkRequestManager::Get()->set_status(send_req.id(),
-                                              WorkStatus::kError);
-        send_req.Notify();
         send_reqs_.Pop();
+        send_drain_lock_.unlock();
+        Finish({send_req_id}, WorkStatus::kError);
+        return;
     }
-    if (send_req.AddBytes(write_nbytes)) {
-        WorkRequestManager::Get()->set_status(send_req.id(),
-                                              WorkStatus::kFinished);
-        send_req.Notify();
-        send_reqs_.Pop();
+    send_lock_.lock();
+    bool more_sends = !send_reqs_.empty();
+    send_lock_.unlock();
+    send_drain_lock_.unlock();
+    Finish(done_reqs, WorkStatus::kFinished);
+    // partially written or more queued meanwhile, wait for the socket to
+    // become writable again
+    if (more_sends) {
+        this->AddEventOfInterest(ChannelKind::kWrite);
     }
     return;
 }
 
+ssize_t TcpChannel::SendHead(WorkRequest& send_req) {
+    auto* addr =
+        send_req.pointer_at<uint8_t>(send_req.processed_bytes_upto_now());
+    if (!zerocopy() || send_req.size_in_bytes() < zerocopy_threshold_) {
+        head_zerocopy_ = false;
+        return sock_.Send(addr, send_req.remain_nbytes());
+    }
+#ifdef MSG_ZEROCOPY
+    auto write_nbytes =
+        sock_.Send(addr, send_req.remain_nbytes(), MSG_ZEROCOPY);
+    if (write_nbytes > 0) {
+        // the kernel numbers every zero copy send that wrote something
+        head_zerocopy_id_ = zerocopy_next_id_++;
+        head_zerocopy_ = true;
+        return write_nbytes;
+    }
+    // out of locked memory for pinned pages, copy this chunk instead
+    if (write_nbytes == -1 && errno != ENOBUFS) {
+        return write_nbytes;
+    }
+#endif
+    return sock_.Send(addr, send_req.remain_nbytes());
+}
+
+ssize_t TcpChannel::SendQueued(std::vector<uint64_t>* done_reqs) {
+    std::vector<uint64_t> send_req_ids;
+    if (send_reqs_.TryPeekFront(&send_req_ids, kMaxBatch) == 0) {
+        return 0;
+    }
+    auto& head_req = WorkRequestManager::Get()->GetWorkRequest(send_req_ids[0]);
+    if (zerocopy() && head_req.size_in_bytes() >= zerocopy_threshold_) {
+        auto write_nbytes = SendHead(head_req);
+        if (write_nbytes > 0 &&
+            head_req.AddBytes(write_nbytes, !head_zerocopy_)) {
+            // an inline send may reuse the head fields once it is popped
+            send_lock_.lock();
+            const bool zerocopy = head_zerocopy_;
+            const uint32_t zerocopy_id = head_zerocopy_id_;
+            head_zerocopy_ = false;
+            send_reqs_.Pop();
+            send_lock_.unlock();
+            if (!HoldZeroCopy(send_req_ids[0], zerocopy, zerocopy_id)) {
+                done_reqs->emplace_back(send_req_ids[0]);
+            }
+        }
+        return write_nbytes;
+    }
+    // small sends queued behind each other leave with one call, up to the
+    // next one which goes zero copy
+    std::vector<iovec> iov;
+    for (const auto& send_req_id : send_req_ids) {
+        auto& send_req = WorkRequestManager::Get()->GetWorkRequest(send_req_id);
+        if (zerocopy() && send_req.size_in_bytes() >= zerocopy_threshold_) {
+            break;
+        }
+        iov.push_back({send_req.pointer_at<uint8_t>(
+                           send_req.processed_bytes_upto_now()),
+                       send_req.remain_nbytes()});
+    }
+    // an empty head is written by no call at all
+    ssize_t write_nbytes = 0;
+    if (iov[0].iov_len != 0) {
+        write_nbytes = sock_.SendV(iov.data(), iov.size());
+        if (write_nbytes == -1) {
+            return write_nbytes;
+        }
+    }
+    // account the whole write before any done callback runs, those may post
+    // to this channel and drain it again
+    const auto& num_done = Credit(send_req_ids, iov.size(), write_nbytes);
+    send_lock_.lock();
+    for (auto i = 0U; i < num_done; i++) {
+        send_reqs_.Pop();
+    }
+    send_lock_.unlock();
+    done_reqs->insert(done_reqs->end(), send_req_ids.begin(),
+                      send_req_ids.begin() + num_done);
+    return write_nbytes;
+}
+
+ssize_t TcpChannel::RecvQueued(std::vector<uint64_t>* done_reqs) {
+    std::vector<uint64_t> recv_req_ids;
+    if (recv_reqs_.TryPeekFront(&recv_req_ids, kMaxBatch) == 0) {
+        return 0;
+    }
+    std::vector<iovec> iov;
+    for (const auto& recv_req_id : recv_req_ids) {
+        auto& recv_req = WorkRequestManager::Get()->GetWorkRequest(recv_req_id);
+        iov.push_back({recv_req.pointer_at<uint8_t>(
+                           recv_req.processed_bytes_upto_now()),
+                       recv_req.remain_nbytes()});
+    }
+    // an empty head is filled by no call at all
+    ssize_t read_nbytes = 0;
+    if (iov[0].iov_len != 0) {
+        read_nbytes = sock_.RecvV(iov.data(), iov.size());
+        if (read_nbytes == -1) {
+            return read_nbytes;
+        }
+    }
+    // account the whole read before any done callback runs, those may post
+    // to this channel and drain it again
+    const auto& num_done = Credit(recv_req_ids, iov.size(), read_nbytes);
+    for (auto i = 0U; i < num_done; i++) {
+        recv_reqs_.Pop();
+    }
+    done_reqs->insert(done_reqs->end(), recv_req_ids.begin(),
+                      recv_req_ids.begin() + num_done);
+    return read_nbytes;
+}
+
+size_t TcpChannel::Credit(const std::vector<uint64_t>& req_ids,
+                          const size_t& num_reqs, const size_t& nbytes) {
+    size_t remain_nbytes = nbytes;
+    for (auto i = 0U; i < num_reqs; i++) {
+        auto& work_req = WorkRequestManager::Get()->GetWorkRequest(req_ids[i]);
+        const size_t req_nbytes =
+            std::min(remain_nbytes, work_req.remain_nbytes());
+        remain_nbytes -= req_nbytes;
+        if (!work_req.AddBytes(req_nbytes)) {
+            return i;
+        }
+    }
+    return num_reqs;
+}
+
+bool TcpChannel::HoldZeroCopy(const uint64_t& send_req_id,
+                              const bool& zerocopy,
+                              const uint32_t& zerocopy_id) {
+    if (!zerocopy) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lg(zerocopy_lock_);
+    // the notification may have come while the tail was written
+    if (static_cast<int32_t>(zerocopy_id - zerocopy_released_) >= 0) {
+        zerocopy_reqs_.emplace_back(zerocopy_id, send_req_id);
+        return true;
+    }
+    return false;
+}
+
+void TcpChannel::Finish(const std::vector<uint64_t>& req_ids,
+                        const WorkStatus& status) {
+    for (const auto& req_id : req_ids) {
+        auto& work_req = WorkRequestManager::Get()->GetWorkRequest(req_id);
+        WorkRequestManager::Get()->set_status(req_id, status);
+        work_req.Notify();
+    }
+}
+
+bool TcpChannel::ReapZeroCopy() {
+    bool reaped = false;
+#ifdef MSG_ZEROCOPY
+    while (true) {
+        char control[CMSG_SPACE(sizeof(sock_extended_err) +
+                                sizeof(sockaddr_in6))];
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(sock_.sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+            break;
+        }
+        for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (!((cmsg->cmsg_level == SOL_IP &&
+                   cmsg->cmsg_type == IP_RECVERR) ||
+                  (cmsg->cmsg_level == SOL_IPV6 &&
+                   cmsg->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            const auto* serr =
+                reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cmsg));
+            if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY ||
+                serr->ee_errno != 0) {
+                return false;
+            }
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                VLOG_F(3, "zero copy send to %d fell back to a copy",
+                       peer_rank());
+            }
+            reaped = true;
+            // ids from ee_info to ee_data are released, tcp keeps them in
+            // order
+            std::vector<uint64_t> done_reqs;
+            zerocopy_lock_.lock();
+            zerocopy_released_ = serr->ee_data + 1;
+            while (!zerocopy_reqs_.empty() &&
+                   static_cast<int32_t>(zerocopy_reqs_.front().first -
+                                        zerocopy_released_) < 0) {
+                done_reqs.emplace_back(zerocopy_reqs_.front().second);
+                zerocopy_reqs_.pop_front();
+            }
+            zerocopy_lock_.unlock();
+            for (const auto& req_id : done_reqs) {
+                auto& send_req =
+                    WorkRequestManager::Get()->GetWorkRequest(req_id);
+                WorkRequestManager::Get()->set_status(req_id,
+                                                      WorkStatus::kFinished);
+                send_req.Notify();
+            }
+        }
+    }
+#endif
+    return reaped;
+}
+
+bool TcpChannel::edge_triggered() const {
+    return adapter_ != nullptr && adapter_->edge_triggered();
+}
+
+void TcpChannel::DrainRecv() {
+    std::vector<uint64_t> done_reqs;
+    std::vector<uint64_t> failed_reqs;
+    recv_drain_lock_.lock();
+    uint64_t recv_req_id = 0;
+    while (!closing_.load(std::memory_order_acquire) &&
+           recv_reqs_.TryPeek(recv_req_id)) {
+        auto& recv_req = WorkRequestManager::Get()->GetWorkRequest(recv_req_id);
+        if (this->error_detected()) {
+            recv_reqs_.Pop();
+            failed_reqs.emplace_back(recv_req_id);
+            continue;
+        }
+        const bool head_filled = recv_req.remain_nbytes() == 0;
+        const auto read_nbytes = RecvQueued(&done_reqs);
+        if (read_nbytes == -1 && errno == EAGAIN) {
+            break;
+        }
+        if (read_nbytes == -1) {
+            this->set_error_detected(true);
+            LOG_F(ERROR, "error detected %s", sys::FormatError(errno).c_str());
+            continue;
+        }
+        // closed by the peer, no edge comes for the requests still queued,
+        // they all fail on the next rounds
+        if (read_nbytes == 0 && !head_filled) {
+            this->set_error_detected(true);
+            LOG_F(ERROR, "channel to %d closed by peer", peer_rank());
+        }
+    }
+    recv_drain_lock_.unlock();
+    // done callbacks may post to other channels and drain those, they must
+    // not run while this channel is locked
+    Finish(done_reqs, WorkStatus::kFinished);
+    Finish(failed_reqs, WorkStatus::kError);
+}
+
+void TcpChannel::DrainSend() {
+    std::vector<uint64_t> done_reqs;
+    std::vector<uint64_t> failed_reqs;
+    send_drain_lock_.lock();
+    uint64_t send_req_id = 0;
+    while (!closing_.load(std::memory_order_acquire) &&
+           send_reqs_.TryPeek(send_req_id)) {
+        if (this->error_detected()) {
+            send_reqs_.Pop();
+            failed_reqs.emplace_back(send_req_id);
+            continue;
+        }
+        const auto write_nbytes = SendQueued(&done_reqs);
+        if (write_nbytes == -1 && errno == EAGAIN) {
+            break;
+        }
+        if (write_nbytes == -1) {
+            this->set_error_detected(true);
+        }
+    }
+    send_drain_lock_.unlock();
+    Finish(done_reqs, WorkStatus::kFinished);
+    Finish(failed_reqs, WorkStatus::kError);
+}
+
 void TcpChannel::DeleteEventOfInterest(const ChannelKind& kind) {
+    // an event polled just before the channel left the poller
+    if (closing_.load(std::memory_order_acquire)) {
+        return;
+    }
     mu_.lock();
     if (kind == ChannelKind::kRead) {
         if (this->kind() == ChannelKind::kReadWrite) {
@@ -113,4 +113,61 @@ GetLinkMap(const uint32_t& num_workers) {
     }
     return std::make_tuple(_tree_map, _parent_map, _ring_map);
 }
+
+std::tuple<int, std::vector<int>> GetBtree(const int& rank,
+                                           const uint32_t& num_workers) {
+    const int n = static_cast<int>(num_workers);
+    std::vector<int> children;
+    // lowest set bit of rank, or the first power of two not less than n
+    int bit = 1;
+    for (; bit < n; bit <<= 1) {
+        if (bit & rank) break;
+    }
+    if (rank == 0) {
+        if (n > 1) {
+            children.emplace_back(bit >> 1);
+        }
+        return std::make_tuple(-1, children);
+    }
+    int parent = (rank ^ bit) | (bit << 1);
+    if (parent >= n) {
+        parent = rank ^ bit;
+    }
+    int lowbit = bit >> 1;
+    if (lowbit != 0) {
+        children.emplace_back(rank - lowbit);
+        // the right child may fall outside of the world, walk down the tree
+        // until it exists
+        int right = rank + lowbit;
+        while (lowbit != 0 && right >= n) {
+            lowbit >>= 1;
+            right = rank + lowbit;
+        }
+        if (lowbit != 0) {
+            children.emplace_back(right);
+        }
+    }
+    return std::make_tuple(parent, children);
+}
+
+std::vector<std::tuple<int, std::vector<int>>> GetDoubleTree(
+    const int& rank, const uint32_t& num_workers) {
+    const int n = static_cast<int>(num_workers);
+    std::vector<std::tuple<int, std::vector<int>>> trees;
+    trees.emplace_back(GetBtree(rank, num_workers));
+    // map ranks of the first tree to ranks of the second one and back
+    auto to_first = [n](int r) { return n % 2 ? (r - 1 + n) % n : n - 1 - r; };
+    auto to_second = [n](int r) {
+        if (r == -1) return -1;
+        return n % 2 ? (r + 1) % n : n - 1 - r;
+    };
+    int parent;
+    std::vector<int> children;
+    std::tie(parent, children) = GetBtree(to_first(rank), num_workers);
+    for (auto& child : children) {
+        child = to_second(child);
+    }
+    trees.emplace_back(std::make_tuple(to_second(parent), children));
+    return trees;
+}
 }
@@ -0,0 +1,66 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file coalesce.cc
+ * \brief This is an example checking receives which are filled by one read,
+ *  the done callback of the first one posts another receive on the same
+ *  channel while the read is still being accounted, edge triggered links
+ *  drain the channel again from inside that callback
+ *
+ * \author AnkunZheng
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "comm/communicator_manager.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_TCP_EDGE_TRIGGERED", "1", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    const int N = 100;
+    for (int i = 0; i < N; ++i) {
+        if (rdc::GetRank() == 0) {
+            std::string str = "AAAABBBBCCCC";
+            str[0] = static_cast<char>('a' + i % 26);
+            // let the receives be posted first, the whole message then
+            // arrives in one read
+            if (i % 10 == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            rdc::Send(&str[0], str.size(), 1);
+        } else if (rdc::GetRank() == 1) {
+            char r1[4], r2[4], r3[4];
+            std::atomic<WorkCompletion *> third{nullptr};
+            auto first = comm->IRecv(Buffer(r1, 4), 0);
+            auto second = comm->IRecv(Buffer(r2, 4), 0);
+            WorkRequestManager::Get()
+                ->GetWorkRequest(first->WorkRequstId())
+                .AddDoneCallback([&](const WorkStatus &) {
+                    third = comm->IRecv(Buffer(r3, 4), 0);
+                });
+            first->Wait();
+            second->Wait();
+            while (third == nullptr) {
+                std::this_thread::yield();
+            }
+            third.load()->Wait();
+            CHECK_F(first->status() == WorkStatus::kFinished);
+            CHECK_F(second->status() == WorkStatus::kFinished);
+            CHECK_F(third.load()->status() == WorkStatus::kFinished);
+            CHECK_EQ_F(r1[0], static_cast<char>('a' + i % 26));
+            CHECK_F(std::strncmp(r1 + 1, "AAA", 3) == 0);
+            CHECK_F(std::strncmp(r2, "BBBB", 4) == 0);
+            CHECK_F(std::strncmp(r3, "CCCC", 4) == 0);
+            WorkCompletion::Delete(first);
+            WorkCompletion::Delete(second);
+            WorkCompletion::Delete(third.load());
+        }
+    }
+    LOG_F(INFO, "@node[%d] coalesced receives passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
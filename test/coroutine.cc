@@ -0,0 +1,60 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file coroutine.cc
+ * \brief This is an example checking coroutines over work completions, a
+ *  task awaits a receive and an allreduce and is awaited by another task,
+ *  it only checks something when built as c++20, see core/coroutine.h
+ *
+ * \author AnkunZheng
+ */
+#include <vector>
+#include "comm/communicator_manager.h"
+#include "core/coroutine.h"
+#include "rdc.h"
+using namespace rdc;
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+Task Exchange(comm::ICommunicator *comm, int *value) {
+    if (rdc::GetRank() == 0) {
+        auto status =
+            co_await Await(comm->ISend(Buffer(value, sizeof(int)), 1));
+        CHECK_F(status == WorkStatus::kFinished);
+    } else if (rdc::GetRank() == 1) {
+        auto status =
+            co_await Await(comm->IRecv(Buffer(value, sizeof(int)), 0));
+        CHECK_F(status == WorkStatus::kFinished);
+    }
+}
+
+Task Step(comm::ICommunicator *comm, int *value, std::vector<int> *a) {
+    co_await Exchange(comm, value);
+    auto status = co_await Await(IAllreduce<op::Sum>(a->data(), a->size()));
+    CHECK_F(status == WorkStatus::kFinished);
+}
+#endif
+int main(int argc, char *argv[]) {
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    for (int round = 0; round < 10; ++round) {
+        int value = rdc::GetRank() == 0 ? round : -1;
+        std::vector<int> a(100, rdc::GetRank() + round);
+        auto step = Step(comm, &value, &a);
+        step.Wait();
+        if (rdc::GetRank() < 2) {
+            CHECK_EQ_F(value, round);
+        }
+        const int world_size = rdc::GetWorldSize();
+        for (auto v : a) {
+            CHECK_EQ_F(v, world_size * (world_size - 1) / 2 +
+                              world_size * round);
+        }
+    }
+    LOG_F(INFO, "@node[%d] coroutine passed", rdc::GetRank());
+#else
+    LOG_F(INFO, "@node[%d] coroutine skipped, not built as c++20",
+          rdc::GetRank());
+#endif
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file eager_rendezvous.cc
+ * \brief This is an example checking the eager limit of framed links, a
+ *  message below it is sent before its receive is posted, one at or above
+ *  it waits until the receiver asks for it
+ *
+ * \author AnkunZheng
+ */
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "comm/communicator_manager.h"
+#include "common/env.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_TCP_FRAMED", "1", 0);
+    setenv("RDC_TCP_EAGER_LIMIT", "4096", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    const uint64_t eager_limit = Env::Get()->GetEnv("RDC_TCP_EAGER_LIMIT", 0);
+    const int kDataTag = 1, kGoTag = 2;
+    for (uint64_t size : {eager_limit - 1, eager_limit, eager_limit * 4}) {
+        const bool eager = size < eager_limit;
+        std::vector<uint8_t> data(size, rdc::GetRank() == 0 ? size % 251 : 0);
+        int go = 0;
+        if (rdc::GetRank() == 0) {
+            auto wc = comm->ISend(Buffer(data.data(), size), 1, kDataTag);
+            if (eager) {
+                // done once copied, the receiver only posts after the go
+                wc->Wait();
+                CHECK_F(wc->status() == WorkStatus::kFinished);
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                CHECK_F(!wc->Test(), "send of %lu bytes finished before its "
+                        "receive was posted", size);
+            }
+            auto go_wc = comm->ISend(Buffer(&go, sizeof(go)), 1, kGoTag);
+            go_wc->Wait();
+            WorkCompletion::Delete(go_wc);
+            wc->Wait();
+            CHECK_F(wc->status() == WorkStatus::kFinished);
+            WorkCompletion::Delete(wc);
+        } else if (rdc::GetRank() == 1) {
+            auto go_wc = comm->IRecv(Buffer(&go, sizeof(go)), 0, kGoTag);
+            go_wc->Wait();
+            WorkCompletion::Delete(go_wc);
+            auto wc = comm->IRecv(Buffer(data.data(), size), 0, kDataTag);
+            wc->Wait();
+            CHECK_F(wc->status() == WorkStatus::kFinished);
+            WorkCompletion::Delete(wc);
+            for (const auto &byte : data) {
+                CHECK_EQ_F(byte, size % 251);
+            }
+        }
+    }
+    LOG_F(INFO, "@node[%d] eager and rendezvous sends passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file edge_triggered.cc
+ * \brief This is an example checking transfers drained inline in edge
+ *  triggered mode, messages larger than the socket buffers stop at EAGAIN
+ *  and go on from the next edge only, many small ones arrive before their
+ *  receives are posted
+ *
+ * \author AnkunZheng
+ */
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "comm/communicator_manager.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_TCP_EDGE_TRIGGERED", "1", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    const int rank = rdc::GetRank();
+    if (rank < 2) {
+        const int peer = 1 - rank;
+        // both ways at once, neither side reads until it has sent
+        for (int N : {1, 1000, 4000000}) {
+            std::vector<int> send(N), recv(N, -1);
+            for (int i = 0; i < N; ++i) {
+                send[i] = rank * N + i;
+            }
+            auto send_wc =
+                comm->ISend(Buffer(send.data(), N * sizeof(int)), peer);
+            auto recv_wc =
+                comm->IRecv(Buffer(recv.data(), N * sizeof(int)), peer);
+            WorkCompletion::WaitAll({send_wc, recv_wc});
+            CHECK_F(send_wc->status() == WorkStatus::kFinished);
+            CHECK_F(recv_wc->status() == WorkStatus::kFinished);
+            WorkCompletion::Delete(send_wc);
+            WorkCompletion::Delete(recv_wc);
+            for (int i = 0; i < N; ++i) {
+                CHECK_EQ_F(recv[i], peer * N + i);
+            }
+        }
+        // everything is in the socket before the first receive is posted
+        const int kNumMsgs = 100;
+        std::vector<int> values(kNumMsgs, -1);
+        if (rank == 0) {
+            for (int i = 0; i < kNumMsgs; ++i) {
+                values[i] = i;
+                rdc::Send(&values[i], sizeof(int), 1);
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            for (int i = 0; i < kNumMsgs; ++i) {
+                rdc::Recv(&values[i], sizeof(int), 0);
+                CHECK_EQ_F(values[i], i);
+            }
+        }
+    }
+    std::vector<int> a(1000, rank);
+    Allreduce<op::Max>(a.data(), a.size());
+    for (auto v : a) {
+        CHECK_EQ_F(v, rdc::GetWorldSize() - 1);
+    }
+    LOG_F(INFO, "@node[%d] edge triggered passed", rank);
+    Finalize();
+    return 0;
+}
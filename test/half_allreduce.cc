@@ -0,0 +1,36 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file half_allreduce.cc
+ * \brief This is an example demonstrating Allreduce on half precision and
+ *  bfloat16, small integers are exact in both types
+ *
+ * \author AnkunZheng
+ */
+#include <vector>
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    int N = 3;
+    if (argc >= 2) N = atoi(argv[1]);
+    std::vector<Half> a(N);
+    std::vector<BFloat16> b(N);
+    std::vector<float> result_sum(N, 0);
+    for (int i = 0; i < N; ++i) {
+        a[i] = Half(static_cast<float>(rdc::GetRank() + i % 8));
+        b[i] = BFloat16(static_cast<float>(rdc::GetRank() + i % 8));
+        for (int j = 0; j < rdc::GetWorldSize(); ++j) {
+            result_sum[i] += j + i % 8;
+        }
+    }
+    Allreduce<op::Sum>(&a[0], N);
+    Allreduce<op::Sum>(&b[0], N);
+    for (int i = 0; i < N; ++i) {
+        DCHECK_EQ_F(static_cast<float>(a[i]), result_sum[i]);
+        DCHECK_EQ_F(static_cast<float>(b[i]), result_sum[i]);
+    }
+    LOG_F(INFO, "@node[%d] half precision allreduce passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
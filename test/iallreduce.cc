@@ -0,0 +1,51 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file iallreduce.cc
+ * \brief This is an example demonstrating non-blocking Allreduce, several
+ *  collectives are issued back to back and waited afterwards
+ *
+ * \author AnkunZheng
+ */
+#include <vector>
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    int N = 3;
+    if (argc >= 2) N = atoi(argv[1]);
+    std::vector<int> a(N), b(N), c(N);
+    std::vector<int> result_max(N, 0), result_sum(N, 0);
+    for (int i = 0; i < N; ++i) {
+        a[i] = b[i] = rdc::GetRank() + N + i;
+        for (int j = 0; j < rdc::GetWorldSize(); ++j) {
+            result_max[i] = std::max(result_max[i], j + N + i);
+            result_sum[i] += (j + N + i);
+        }
+    }
+    int root = rdc::GetWorldSize() - 1;
+    for (int i = 0; i < N; ++i) {
+        c[i] = rdc::GetRank() == root ? i : -1;
+    }
+    // issue all collectives before waiting any of them
+    auto max_wc = IAllreduce<op::Max>(&a[0], N);
+    auto sum_wc = IAllreduce<op::Sum>(&b[0], N);
+    auto bcast_wc = IBroadcast(&c[0], N * sizeof(int), root);
+    bcast_wc->Wait();
+    sum_wc->Wait();
+    max_wc->Wait();
+    DCHECK_F(max_wc->status() == WorkStatus::kFinished);
+    DCHECK_F(sum_wc->status() == WorkStatus::kFinished);
+    DCHECK_F(bcast_wc->status() == WorkStatus::kFinished);
+    WorkCompletion::Delete(max_wc);
+    WorkCompletion::Delete(sum_wc);
+    WorkCompletion::Delete(bcast_wc);
+    for (int i = 0; i < N; ++i) {
+        DCHECK_EQ_F(a[i], result_max[i]);
+        DCHECK_EQ_F(b[i], result_sum[i]);
+        DCHECK_EQ_F(c[i], i);
+    }
+    LOG_F(INFO, "@node[%d] non-blocking collectives passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
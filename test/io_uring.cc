@@ -0,0 +1,56 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file io_uring.cc
+ * \brief This is an example checking the io_uring backend, many sends and
+ *  receives are in flight on one link at once and must land in posting
+ *  order, the backend is only picked when the library is built with it
+ *
+ * \author AnkunZheng
+ */
+#include <cstdlib>
+#include <vector>
+#include "comm/communicator_manager.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+#ifdef RDC_USE_IO_URING
+    setenv("RDC_BACKEND", "IO_URING", 0);
+#endif
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    const int kNumMsgs = 16;
+    for (int N : {1, 1000, 1000000}) {
+        std::vector<std::vector<int>> bufs(kNumMsgs, std::vector<int>(N, -1));
+        std::vector<WorkCompletion *> wcs;
+        for (int j = 0; j < kNumMsgs; ++j) {
+            if (rdc::GetRank() == 0) {
+                bufs[j].assign(N, j);
+                wcs.emplace_back(
+                    comm->ISend(Buffer(bufs[j].data(), N * sizeof(int)), 1));
+            } else if (rdc::GetRank() == 1) {
+                wcs.emplace_back(
+                    comm->IRecv(Buffer(bufs[j].data(), N * sizeof(int)), 0));
+            }
+        }
+        WorkCompletion::WaitAll(wcs);
+        for (auto wc : wcs) {
+            CHECK_F(wc->status() == WorkStatus::kFinished);
+            WorkCompletion::Delete(wc);
+        }
+        if (rdc::GetRank() == 1) {
+            for (int j = 0; j < kNumMsgs; ++j) {
+                CHECK_EQ_F(bufs[j][0], j);
+                CHECK_EQ_F(bufs[j][N - 1], j);
+            }
+        }
+        std::vector<int> a(N, rdc::GetRank());
+        Allreduce<op::Sum>(a.data(), N);
+        const int world_size = rdc::GetWorldSize();
+        CHECK_EQ_F(a[0], world_size * (world_size - 1) / 2);
+        CHECK_EQ_F(a[N - 1], world_size * (world_size - 1) / 2);
+    }
+    LOG_F(INFO, "@node[%d] io_uring passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file ipc_rendezvous.cc
+ * \brief This is an example checking large messages between ranks on one
+ *  host, which the receiver reads straight out of the sender, the sender
+ *  may only finish once that read is done, so it overwrites its buffer
+ *  right after the wait and the receiver must still see the old contents
+ *
+ * \author AnkunZheng
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_IPC_RNDV_THRESHOLD", "4096", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    // below, at and above the threshold, the last one larger than the ring
+    for (int N : {1023, 1024, 100000, 2000000}) {
+        std::vector<int> buf(N);
+        for (int round = 0; round < 3; ++round) {
+            if (rdc::GetRank() == 0) {
+                for (int i = 0; i < N; ++i) {
+                    buf[i] = round * N + i;
+                }
+                rdc::Send(buf.data(), N * sizeof(int), 1);
+                std::fill(buf.begin(), buf.end(), -1);
+            } else if (rdc::GetRank() == 1) {
+                rdc::Recv(buf.data(), N * sizeof(int), 0);
+                for (int i = 0; i < N; ++i) {
+                    CHECK_EQ_F(buf[i], round * N + i);
+                }
+            }
+        }
+    }
+    LOG_F(INFO, "@node[%d] ipc rendezvous passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
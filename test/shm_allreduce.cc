@@ -0,0 +1,43 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file shm_allreduce.cc
+ * \brief This is an example checking allreduce and broadcast of ranks which
+ *  all live on one host and share an arena, slots are kept small so that
+ *  larger buffers take many rounds through them
+ *
+ * \author AnkunZheng
+ */
+#include <cstdlib>
+#include <vector>
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_IPC_COLL_SLOT_SIZE", "4096", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    const int world_size = rdc::GetWorldSize();
+    for (int N : {1, 3, 1000, 100000}) {
+        std::vector<int> a(N), b(N);
+        for (int i = 0; i < N; ++i) {
+            a[i] = rdc::GetRank() + i;
+            b[i] = rdc::GetRank() == 0 ? N - i : -1;
+        }
+        Allreduce<op::Sum>(a.data(), N);
+        Broadcast(b.data(), N * sizeof(int), 0);
+        for (int i = 0; i < N; ++i) {
+            CHECK_EQ_F(a[i],
+                       world_size * (world_size - 1) / 2 + world_size * i);
+            CHECK_EQ_F(b[i], N - i);
+        }
+        for (int i = 0; i < N; ++i) {
+            a[i] = rdc::GetRank() * i;
+        }
+        Allreduce<op::Max>(a.data(), N);
+        for (int i = 0; i < N; ++i) {
+            CHECK_EQ_F(a[i], (world_size - 1) * i);
+        }
+    }
+    LOG_F(INFO, "@node[%d] shm allreduce passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,44 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file shm_ring.cc
+ * \brief This is an example checking messages between ranks on one host
+ *  through the shared memory ring of their pair, the ring is kept at its
+ *  smallest so that messages wrap around it and larger ones than the ring
+ *  wait for the reader to free space
+ *
+ * \author AnkunZheng
+ */
+#include <cstdlib>
+#include <vector>
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_IPC_RING_SIZE", "4096", 0);
+    // every message goes through the ring, none is pulled
+    setenv("RDC_IPC_RNDV_THRESHOLD", "0", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    for (int N : {1, 100, 1000, 5000, 100000}) {
+        std::vector<int> buf(N);
+        if (rdc::GetRank() == 0) {
+            for (int i = 0; i < N; ++i) {
+                buf[i] = N + i;
+            }
+            rdc::Send(buf.data(), N * sizeof(int), 1);
+            rdc::Recv(buf.data(), N * sizeof(int), 1);
+            for (int i = 0; i < N; ++i) {
+                CHECK_EQ_F(buf[i], N - i);
+            }
+        } else if (rdc::GetRank() == 1) {
+            rdc::Recv(buf.data(), N * sizeof(int), 0);
+            for (int i = 0; i < N; ++i) {
+                CHECK_EQ_F(buf[i], N + i);
+                buf[i] = N - i;
+            }
+            rdc::Send(buf.data(), N * sizeof(int), 0);
+        }
+    }
+    LOG_F(INFO, "@node[%d] shm ring passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file striping.cc
+ * \brief This is an example checking links striped over several tcp
+ *  connections, messages above the threshold are split across the stripes
+ *  in sizes that do not divide evenly, several are in flight at once and
+ *  must be put back together in order
+ *
+ * \author AnkunZheng
+ */
+#include <cstdlib>
+#include <vector>
+#include "comm/communicator_manager.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_TCP_NUM_STRIPES", "4", 0);
+    setenv("RDC_TCP_STRIPE_THRESHOLD", "4096", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    const int kNumMsgs = 8;
+    for (int N : {3, 1023, 1025, 1000003}) {
+        std::vector<std::vector<int>> bufs(kNumMsgs, std::vector<int>(N, -1));
+        std::vector<WorkCompletion *> wcs;
+        for (int j = 0; j < kNumMsgs; ++j) {
+            if (rdc::GetRank() == 0) {
+                for (int i = 0; i < N; ++i) {
+                    bufs[j][i] = j * N + i;
+                }
+                wcs.emplace_back(
+                    comm->ISend(Buffer(bufs[j].data(), N * sizeof(int)), 1));
+            } else if (rdc::GetRank() == 1) {
+                wcs.emplace_back(
+                    comm->IRecv(Buffer(bufs[j].data(), N * sizeof(int)), 0));
+            }
+        }
+        WorkCompletion::WaitAll(wcs);
+        for (auto wc : wcs) {
+            CHECK_F(wc->status() == WorkStatus::kFinished);
+            WorkCompletion::Delete(wc);
+        }
+        if (rdc::GetRank() == 1) {
+            for (int j = 0; j < kNumMsgs; ++j) {
+                for (int i = 0; i < N; ++i) {
+                    CHECK_EQ_F(bufs[j][i], j * N + i);
+                }
+            }
+        }
+        std::vector<int> a(N, rdc::GetRank() + 1);
+        Allreduce<op::Max>(a.data(), N);
+        for (auto v : a) {
+            CHECK_EQ_F(v, rdc::GetWorldSize());
+        }
+    }
+    LOG_F(INFO, "@node[%d] striping passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,65 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file tagged_sendrecv.cc
+ * \brief This is an example checking that tagged receives are matched by
+ *  tag and not by posting order, small messages go eager and large ones
+ *  through the rts/cts handshake, tags need framed links
+ *
+ * \author AnkunZheng
+ */
+#include <cstdlib>
+#include <vector>
+#include "comm/communicator_manager.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_TCP_FRAMED", "1", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    const int kNumTags = 4;
+    for (int N : {0, 10, 100000}) {
+        std::vector<std::vector<int>> bufs(kNumTags);
+        if (rdc::GetRank() == 0) {
+            std::vector<WorkCompletion *> wcs;
+            for (int tag = 1; tag <= kNumTags; ++tag) {
+                bufs[tag - 1].assign(N + tag, tag * 100);
+                wcs.emplace_back(comm->ISend(
+                    Buffer(bufs[tag - 1].data(), (N + tag) * sizeof(int)), 1,
+                    tag));
+            }
+            for (auto wc : wcs) {
+                wc->Wait();
+                CHECK_F(wc->status() == WorkStatus::kFinished);
+                WorkCompletion::Delete(wc);
+            }
+        } else if (rdc::GetRank() == 1) {
+            for (int tag = 1; tag <= kNumTags; ++tag) {
+                bufs[tag - 1].assign(N + kNumTags, -1);
+            }
+            // the third message first, while the first two are in flight
+            auto third = comm->IRecv(
+                Buffer(bufs[2].data(), (N + 3) * sizeof(int)), 0, 3);
+            third->Wait();
+            // any tag takes the oldest message left, which is the second
+            auto first = comm->IRecv(
+                Buffer(bufs[0].data(), (N + 1) * sizeof(int)), 0, 1);
+            auto any = comm->IRecv(
+                Buffer(bufs[1].data(), (N + 2) * sizeof(int)), 0, kAnyTag);
+            auto fourth = comm->IRecv(
+                Buffer(bufs[3].data(), (N + 4) * sizeof(int)), 0, 4);
+            for (auto wc : {third, first, any, fourth}) {
+                wc->Wait();
+                CHECK_F(wc->status() == WorkStatus::kFinished);
+                WorkCompletion::Delete(wc);
+            }
+            for (int tag = 1; tag <= kNumTags; ++tag) {
+                CHECK_EQ_F(bufs[tag - 1][0], tag * 100);
+                CHECK_EQ_F(bufs[tag - 1][N + tag - 1], tag * 100);
+            }
+        }
+    }
+    LOG_F(INFO, "@node[%d] tagged sendrecv passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
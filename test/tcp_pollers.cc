@@ -0,0 +1,42 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file tcp_pollers.cc
+ * \brief This is an example checking transfers with channels sharded over
+ *  several poller threads, both ranks send and receive at once while
+ *  allreduces run over the same links
+ *
+ * \author AnkunZheng
+ */
+#include <cstdlib>
+#include <vector>
+#include "comm/communicator_manager.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_TCP_NUM_POLLERS", "4", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    const int world_size = rdc::GetWorldSize();
+    const int rank = rdc::GetRank();
+    const int next = (rank + 1) % world_size;
+    const int prev = (rank + world_size - 1) % world_size;
+    for (int N : {1, 1000, 1000000}) {
+        std::vector<int> send(N, rank), recv(N, -1), a(N, rank);
+        auto send_wc = comm->ISend(Buffer(send.data(), N * sizeof(int)), next);
+        auto recv_wc = comm->IRecv(Buffer(recv.data(), N * sizeof(int)), prev);
+        auto allreduce_wc = IAllreduce<op::Sum>(a.data(), N);
+        WorkCompletion::WaitAll({send_wc, recv_wc, allreduce_wc});
+        for (auto wc : {send_wc, recv_wc, allreduce_wc}) {
+            CHECK_F(wc->status() == WorkStatus::kFinished);
+            WorkCompletion::Delete(wc);
+        }
+        for (int i = 0; i < N; ++i) {
+            CHECK_EQ_F(recv[i], prev);
+            CHECK_EQ_F(a[i], world_size * (world_size - 1) / 2);
+        }
+    }
+    LOG_F(INFO, "@node[%d] tcp pollers passed", rank);
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file then.cc
+ * \brief This is an example checking done callbacks and continuations, a
+ *  receive is chained to the one before it and the reply to both of them,
+ *  and a broadcast is chained to an allreduce without blocking in between
+ *
+ * \author AnkunZheng
+ */
+#include <atomic>
+#include <vector>
+#include "comm/communicator_manager.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    for (int round = 0; round < 10; ++round) {
+        int a = -1, b = -1, sum = -1;
+        if (rdc::GetRank() == 0) {
+            a = round;
+            b = round * 2;
+            rdc::Send(&a, sizeof(a), 1);
+            rdc::Send(&b, sizeof(b), 1);
+            rdc::Recv(&sum, sizeof(sum), 1);
+            CHECK_EQ_F(sum, round * 3);
+        } else if (rdc::GetRank() == 1) {
+            std::atomic<int> num_done{0};
+            auto first = comm->IRecv(Buffer(&a, sizeof(a)), 0);
+            first->OnDone([&](const WorkStatus &status) {
+                CHECK_F(status == WorkStatus::kFinished);
+                CHECK_EQ_F(a, round);
+                num_done++;
+            });
+            auto second = first->Then(
+                [&] { return comm->IRecv(Buffer(&b, sizeof(b)), 0); });
+            auto reply = second->Then([&] {
+                sum = a + b;
+                return comm->ISend(Buffer(&sum, sizeof(sum)), 0);
+            });
+            reply->OnDone([&](const WorkStatus &) { num_done++; });
+            reply->Wait();
+            CHECK_F(reply->status() == WorkStatus::kFinished);
+            CHECK_F(second->Test());
+            CHECK_EQ_F(b, round * 2);
+            WorkCompletion::Delete(first);
+            WorkCompletion::Delete(second);
+            WorkCompletion::Delete(reply);
+            CHECK_EQ_F(num_done.load(), 2);
+        }
+    }
+    const int N = 1000;
+    std::vector<int> a(N), b(N);
+    for (int i = 0; i < N; ++i) {
+        a[i] = rdc::GetRank() + i;
+    }
+    auto allreduce = IAllreduce<op::Max>(a.data(), N);
+    auto broadcast = allreduce->Then([&] {
+        // the root forwards what the allreduce left in a
+        if (rdc::GetRank() == 0) {
+            b = a;
+        }
+        return IBroadcast(b.data(), N * sizeof(int), 0);
+    });
+    broadcast->Wait();
+    CHECK_F(broadcast->status() == WorkStatus::kFinished);
+    WorkCompletion::Delete(allreduce);
+    WorkCompletion::Delete(broadcast);
+    for (int i = 0; i < N; ++i) {
+        CHECK_EQ_F(b[i], rdc::GetWorldSize() - 1 + i);
+    }
+    LOG_F(INFO, "@node[%d] then passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file wait_any.cc
+ * \brief This is an example checking Test, WaitAny, WaitSome and WaitAll,
+ *  rank 0 holds the later messages back until rank 1 has seen the first
+ *  one, so which receives are done at each point is known
+ *
+ * \author AnkunZheng
+ */
+#include <vector>
+#include "comm/communicator_manager.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    const int kNumMsgs = 4;
+    for (int round = 0; round < 10; ++round) {
+        std::vector<int> values(kNumMsgs);
+        int go = 0;
+        if (rdc::GetRank() == 0) {
+            values[0] = round;
+            rdc::Send(&values[0], sizeof(int), 1);
+            rdc::Recv(&go, sizeof(go), 1);
+            std::vector<WorkCompletion *> wcs;
+            for (int i = 1; i < kNumMsgs; ++i) {
+                values[i] = round + i;
+                wcs.emplace_back(
+                    comm->ISend(Buffer(&values[i], sizeof(int)), 1));
+            }
+            WorkCompletion::WaitAll(wcs);
+            for (auto wc : wcs) {
+                CHECK_F(wc->status() == WorkStatus::kFinished);
+                WorkCompletion::Delete(wc);
+            }
+        } else if (rdc::GetRank() == 1) {
+            std::vector<WorkCompletion *> wcs;
+            for (int i = 0; i < kNumMsgs; ++i) {
+                values[i] = -1;
+                wcs.emplace_back(
+                    comm->IRecv(Buffer(&values[i], sizeof(int)), 0));
+            }
+            CHECK_EQ_F(WorkCompletion::WaitAny(wcs), 0U);
+            CHECK_EQ_F(values[0], round);
+            // nothing else is sent before the go
+            for (int i = 1; i < kNumMsgs; ++i) {
+                CHECK_F(!wcs[i]->Test());
+            }
+            auto done = WorkCompletion::WaitSome(wcs);
+            CHECK_EQ_F(done[0], 0U);
+            rdc::Send(&go, sizeof(go), 0);
+            WorkCompletion::WaitAll(wcs);
+            done = WorkCompletion::WaitSome(wcs);
+            CHECK_EQ_F(done.size(), static_cast<size_t>(kNumMsgs));
+            for (int i = 0; i < kNumMsgs; ++i) {
+                CHECK_F(wcs[i]->Test());
+                CHECK_EQ_F(values[i], round + i);
+                WorkCompletion::Delete(wcs[i]);
+            }
+        }
+    }
+    LOG_F(INFO, "@node[%d] wait any passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,51 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file work_request_recycle.cc
+ * \brief This is an example checking that slots of deleted work requests are
+ *  recycled, many more requests than the slab holds go through it one after
+ *  another, and that ids of recycled slots are stale, setting their status
+ *  must not touch the request which took the slot over
+ *
+ * \author AnkunZheng
+ */
+#include <cstdlib>
+#include "comm/communicator_manager.h"
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_MAX_WORK_REQUESTS", "2048", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    auto comm = comm::CommunicatorManager::Get()->GetCommunicator();
+    auto mgr = WorkRequestManager::Get();
+    const int N = 10000;
+    uint64_t stale_id = 0;
+    int num_recycled = 0;
+    for (int i = 0; i < N; ++i) {
+        int value = rdc::GetRank() == 0 ? i : -1;
+        WorkCompletion *wc = nullptr;
+        if (rdc::GetRank() == 0) {
+            wc = comm->ISend(Buffer(&value, sizeof(value)), 1);
+        } else if (rdc::GetRank() == 1) {
+            wc = comm->IRecv(Buffer(&value, sizeof(value)), 0);
+        } else {
+            continue;
+        }
+        // the slot of the last request is usually the first one reused
+        if (stale_id != 0 && !mgr->Contain(stale_id)) {
+            mgr->set_status(stale_id, WorkStatus::kError);
+            num_recycled++;
+        }
+        wc->Wait();
+        CHECK_F(wc->status() == WorkStatus::kFinished);
+        CHECK_EQ_F(value, i);
+        stale_id = wc->WorkRequstId();
+        WorkCompletion::Delete(wc);
+    }
+    if (rdc::GetRank() < 2) {
+        CHECK_F(num_recycled > 0);
+    }
+    LOG_F(INFO, "@node[%d] work request recycling passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*!
+ *  Copyright (c) 2018 by Contributors
+ * \file zerocopy.cc
+ * \brief This is an example checking zero copy sends, a send above the
+ *  threshold only finishes once the kernel has released its pages, so the
+ *  sender overwrites its buffer right after the wait and the receiver must
+ *  still see the old contents, smaller sends in between are copied
+ *
+ * \author AnkunZheng
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "rdc.h"
+using namespace rdc;
+int main(int argc, char *argv[]) {
+    setenv("RDC_TCP_ZEROCOPY_THRESHOLD", "16384", 0);
+    rdc::Init(argc, argv);
+    rdc::NewCommunicator(rdc::kMainCommName);
+    for (int round = 0; round < 5; ++round) {
+        // below, at and above the threshold
+        for (int N : {100, 4096, 1000000}) {
+            std::vector<int> buf(N);
+            if (rdc::GetRank() == 0) {
+                for (int i = 0; i < N; ++i) {
+                    buf[i] = round + i;
+                }
+                rdc::Send(buf.data(), N * sizeof(int), 1);
+                std::fill(buf.begin(), buf.end(), -1);
+            } else if (rdc::GetRank() == 1) {
+                rdc::Recv(buf.data(), N * sizeof(int), 0);
+                for (int i = 0; i < N; ++i) {
+                    CHECK_EQ_F(buf[i], round + i);
+                }
+            }
+        }
+    }
+    LOG_F(INFO, "@node[%d] zerocopy passed", rdc::GetRank());
+    Finalize();
+    return 0;
+}
@@ -186,7 +186,8 @@ class TrackerHandler:
                 self.tracker.rank_cond.notify_all()
 
         # sync ranks of peer nodes which have same host to all worker
-        peers_with_same_addr = self.tracker.addr_to_ranks[self.addr]
+        peers_with_same_addr = self.tracker.addr_to_ranks[utils.parse_host(
+            self.addr)]
         self.sendint(len(peers_with_same_addr))
         for peer_with_same_addr in peers_with_same_addr:
             self.sendint(peer_with_same_addr)
@@ -57,6 +57,19 @@ def build_addr(backend, host, port):
     return "%s:%s:%d" % (backend, host, port)
 
 
+def parse_host(addr):
+    """host part of an address built by build_addr"""
+    return addr.split(':')[1]
+
+
+def invert_dict(addrs):
+    """map every host to the sorted ranks whose address is on it"""
+    host_to_ranks = dict()
+    for rank, addr in sorted(addrs.items()):
+        host_to_ranks.setdefault(parse_host(addr), []).append(rank)
+    return host_to_ranks
+
+
 def config_logger(args):
     FORMAT = '[%(asctime)s (%(name)s:%(lineno)s) %(levelname)s] %(message)s'
     level = args.log_level if 'log_level' in args else 'DEBUG'